@@ -0,0 +1,89 @@
+#pragma once
+
+// CIŃvOC̃RpCƃNm߂邽߂́AVLC 3 SDK̃X^u
+// cas.cpp p錾݂̂AVLC 3.0 ƓOƌ^ŗpӂ
+// `͖߁AvOCVLCœǂ߂Ȃ
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int64_t mtime_t;
+#define CLOCK_FREQ INT64_C(1000000)
+#define VLC_TS_INVALID INT64_C(0)
+mtime_t mdate(void);
+
+#define VLC_SUCCESS 0
+#define VLC_EGENERIC (-1)
+#define VLC_ENOMEM (-2)
+
+typedef struct vlc_object_t
+{
+	const char *obj_type;
+} vlc_object_t;
+#define VLC_OBJECT(x) ((vlc_object_t *)(x))
+
+typedef union
+{
+	int64_t i_int;
+	bool b_bool;
+	float f_float;
+	char *psz_string;
+	void *p_address;
+} vlc_value_t;
+
+enum vlc_log_type
+{
+	VLC_MSG_INFO = 0,
+	VLC_MSG_ERR,
+	VLC_MSG_WARN,
+	VLC_MSG_DBG,
+};
+
+extern const char vlc_module_name[];
+void vlc_vaLog(vlc_object_t *obj, int prio, const char *module, const char *file, unsigned line, const char *func, const char *format, va_list args);
+
+typedef uint32_t vlc_fourcc_t;
+#define VLC_FOURCC(a, b, c, d) ((uint32_t)(uint8_t)(a) | ((uint32_t)(uint8_t)(b) << 8) | ((uint32_t)(uint8_t)(c) << 16) | ((uint32_t)(uint8_t)(d) << 24))
+#define VLC_CODEC_I420 VLC_FOURCC('I','4','2','0')
+#define VLC_CODEC_I420_10L VLC_FOURCC('I','0','A','L')
+#define VLC_CODEC_I420_10B VLC_FOURCC('I','0','A','B')
+#define VLC_CODEC_I420_16L VLC_FOURCC('I','0','F','L')
+#define VLC_CODEC_I422 VLC_FOURCC('I','4','2','2')
+#define VLC_CODEC_RGB24 VLC_FOURCC('R','V','2','4')
+#define VLC_CODEC_RGB32 VLC_FOURCC('R','V','3','2')
+#define VLC_CODEC_RGBA VLC_FOURCC('R','G','B','A')
+#define VLC_CODEC_D3D11_OPAQUE VLC_FOURCC('D','X','1','1')
+
+typedef struct video_format_t
+{
+	vlc_fourcc_t i_chroma;
+	unsigned int i_width;
+	unsigned int i_height;
+	unsigned int i_x_offset;
+	unsigned int i_y_offset;
+	unsigned int i_visible_width;
+	unsigned int i_visible_height;
+	unsigned int i_bits_per_pixel;
+	unsigned int i_sar_num;
+	unsigned int i_sar_den;
+	unsigned int i_frame_rate;
+	unsigned int i_frame_rate_base;
+} video_format_t;
+bool video_format_IsSimilar(const video_format_t *f1, const video_format_t *f2);
+
+typedef struct config_chain_t config_chain_t;
+void config_ChainParse(vlc_object_t *obj, const char *prefix, const char *const *options, config_chain_t *cfg);
+#define config_ChainParse(o, p, opts, cfg) config_ChainParse(VLC_OBJECT(o), p, opts, cfg)
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,36 @@
+#pragma once
+
+// rfItB^̃X^u
+
+#include "vlc_common.h"
+#include "vlc_picture.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct es_format_t
+{
+	video_format_t video;
+} es_format_t;
+
+typedef struct filter_sys_t filter_sys_t;
+
+typedef struct filter_t
+{
+	vlc_object_t obj;
+	void *p_module;
+	filter_sys_t *p_sys;
+	es_format_t fmt_in;
+	es_format_t fmt_out;
+	bool b_allow_fmt_out_change;
+	config_chain_t *p_cfg;
+	picture_t *(*pf_video_filter)(struct filter_t *filter, picture_t *picture);
+	void (*pf_flush)(struct filter_t *filter);
+} filter_t;
+
+picture_t *filter_NewPicture(filter_t *filter);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,49 @@
+#pragma once
+
+// sN`̃X^u
+// SDK ƓAQƐ picture_priv_t (src/misc/picture.h) ͊܂߂Ȃ
+
+#include "vlc_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PICTURE_PLANE_MAX 5
+
+typedef struct plane_t
+{
+	uint8_t *p_pixels;
+	int i_lines;
+	int i_pitch;
+	int i_pixel_pitch;
+	int i_visible_lines;
+	int i_visible_pitch;
+} plane_t;
+
+typedef struct picture_sys_t picture_sys_t;
+
+typedef struct picture_t
+{
+	video_format_t format;
+	plane_t p[PICTURE_PLANE_MAX];
+	int i_planes;
+	mtime_t date;
+	bool b_force;
+	bool b_progressive;
+	bool b_top_field_first;
+	unsigned int i_nb_fields;
+	void *context;
+	picture_sys_t *p_sys;
+	struct picture_t *p_next;
+} picture_t;
+
+picture_t *picture_Hold(picture_t *picture);
+void picture_Release(picture_t *picture);
+void picture_CopyProperties(picture_t *dst, const picture_t *src);
+void picture_CopyPixels(picture_t *dst, const picture_t *src);
+void picture_Copy(picture_t *dst, const picture_t *src);
+
+#ifdef __cplusplus
+}
+#endif
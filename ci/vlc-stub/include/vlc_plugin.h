@@ -0,0 +1,36 @@
+#pragma once
+
+// W[̋Lq̃X^u
+// VLC 3 Ɠ}NALq֐ƕQƂ邾 vlc_entry ɓWJ
+
+#include "vlc_common.h"
+
+#define CAT_VIDEO 4
+#define SUBCAT_VIDEO_VFILTER 402
+
+#ifdef __cplusplus
+#define VLC_STUB_EXTERN_C extern "C"
+#else
+#define VLC_STUB_EXTERN_C
+#endif
+
+#define vlc_module_begin() \
+	VLC_STUB_EXTERN_C const char vlc_module_name[] = MODULE_STRING; \
+	VLC_STUB_EXTERN_C int vlc_entry(void); \
+	VLC_STUB_EXTERN_C int vlc_entry(void) {
+#define vlc_module_end() return 0; }
+
+#define VLC_STUB_USE(x) (void)(x);
+#define set_shortname(name) VLC_STUB_USE(name)
+#define set_description(desc) VLC_STUB_USE(desc)
+#define set_capability(cap, score) VLC_STUB_USE(cap) VLC_STUB_USE(score)
+#define set_category(cat) VLC_STUB_USE(cat)
+#define set_subcategory(subcat) VLC_STUB_USE(subcat)
+#define add_shortcut(name) VLC_STUB_USE(name)
+#define set_callbacks(activate, deactivate) VLC_STUB_USE(activate) VLC_STUB_USE(deactivate)
+#define add_integer(name, value, text, longtext, advc) VLC_STUB_USE(name) VLC_STUB_USE(value) VLC_STUB_USE(text) VLC_STUB_USE(longtext) VLC_STUB_USE(advc)
+#define add_integer_with_range(name, value, min, max, text, longtext, advc) add_integer(name, value, text, longtext, advc) VLC_STUB_USE(min) VLC_STUB_USE(max)
+#define add_float_with_range(name, value, min, max, text, longtext, advc) add_integer(name, value, text, longtext, advc) VLC_STUB_USE(min) VLC_STUB_USE(max)
+#define add_bool(name, value, text, longtext, advc) add_integer(name, value, text, longtext, advc)
+#define add_string(name, value, text, longtext, advc) add_integer(name, value, text, longtext, advc)
+#define change_integer_list(values, texts) VLC_STUB_USE(values) VLC_STUB_USE(texts)
@@ -0,0 +1,41 @@
+#pragma once
+
+// IuWFNg̕ϐ̃X^u
+
+#include "vlc_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VLC_VAR_INTEGER 0x0030
+#define VLC_VAR_FLOAT 0x0050
+#define VLC_VAR_STRING 0x0040
+#define VLC_VAR_BOOL 0x0020
+#define VLC_VAR_DOINHERIT 0x8000
+
+typedef int (*vlc_callback_t)(vlc_object_t *obj, const char *name, vlc_value_t old_value, vlc_value_t new_value, void *data);
+
+int var_Create(vlc_object_t *obj, const char *name, int type);
+void var_Destroy(vlc_object_t *obj, const char *name);
+void var_AddCallback(vlc_object_t *obj, const char *name, vlc_callback_t callback, void *data);
+void var_DelCallback(vlc_object_t *obj, const char *name, vlc_callback_t callback, void *data);
+int64_t var_GetInteger(vlc_object_t *obj, const char *name);
+bool var_GetBool(vlc_object_t *obj, const char *name);
+float var_GetFloat(vlc_object_t *obj, const char *name);
+char *var_GetString(vlc_object_t *obj, const char *name);
+int var_SetInteger(vlc_object_t *obj, const char *name, int64_t value);
+
+#define var_Create(o, n, t) var_Create(VLC_OBJECT(o), n, t)
+#define var_Destroy(o, n) var_Destroy(VLC_OBJECT(o), n)
+#define var_AddCallback(o, n, c, d) var_AddCallback(VLC_OBJECT(o), n, c, d)
+#define var_DelCallback(o, n, c, d) var_DelCallback(VLC_OBJECT(o), n, c, d)
+#define var_GetInteger(o, n) var_GetInteger(VLC_OBJECT(o), n)
+#define var_GetBool(o, n) var_GetBool(VLC_OBJECT(o), n)
+#define var_GetFloat(o, n) var_GetFloat(VLC_OBJECT(o), n)
+#define var_GetString(o, n) var_GetString(VLC_OBJECT(o), n)
+#define var_SetInteger(o, n, v) var_SetInteger(VLC_OBJECT(o), n, v)
+
+#ifdef __cplusplus
+}
+#endif
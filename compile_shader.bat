@@ -1,3 +1,9 @@
 IF NOT EXIST res mkdir res
 fxc /nologo /T cs_5_0 /Qstrip_reflect /Fo res\cas.cso src\cas.hlsl
+fxc /nologo /T cs_5_0 /Qstrip_reflect /D CAS_QUALITY=1 /Fo res\cas_q1.cso src\cas.hlsl
+fxc /nologo /T cs_5_0 /Qstrip_reflect /D CAS_QUALITY=2 /Fo res\cas_q2.cso src\cas.hlsl
+fxc /nologo /T cs_5_0 /Qstrip_reflect /D CAS_QUALITY=3 /Fo res\cas_q3.cso src\cas.hlsl
 fxc /nologo /T cs_5_0 /Qstrip_reflect /D USE_FP16=1 /Fo res\cashalf.cso src\cas.hlsl
+fxc /nologo /T cs_5_0 /Qstrip_reflect /D USE_FP16=1 /D CAS_QUALITY=1 /Fo res\cashalf_q1.cso src\cas.hlsl
+fxc /nologo /T cs_5_0 /Qstrip_reflect /D USE_FP16=1 /D CAS_QUALITY=2 /Fo res\cashalf_q2.cso src\cas.hlsl
+fxc /nologo /T cs_5_0 /Qstrip_reflect /D USE_FP16=1 /D CAS_QUALITY=3 /Fo res\cashalf_q3.cso src\cas.hlsl
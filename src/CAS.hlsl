@@ -1,11 +1,22 @@
 //-D USE_FP16
+//-D CAS_QUALITY=n (0: CAS_SLOW, CAS_GO_SLOWER, CAS_BETTER_DIAGONALS, 1: CAS_SLOW, CAS_GO_SLOWER, 2: CAS_SLOW, 3: none)
 
 #define SRGB_SOURCE 1
 #define A_GPU 1
 #define A_HLSL 1
+
+#ifndef CAS_QUALITY
+#define CAS_QUALITY 0
+#endif
+#if CAS_QUALITY < 3
 #define CAS_SLOW 1
+#endif
+#if CAS_QUALITY < 2
 #define CAS_GO_SLOWER 1
+#endif
+#if CAS_QUALITY < 1
 #define CAS_BETTER_DIAGONALS 1
+#endif
 
 #if USE_FP16
 #define A_HALF 1
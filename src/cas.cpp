@@ -1,20 +1,45 @@
+// D3D11ł̏́AWindowsł̂ݗpł
+// ȊO̊ł́ACPUŏ
+#if !defined(CAS_USE_D3D11) && defined(_WIN32)
+#define CAS_USE_D3D11 1
+#endif
+
+#if CAS_USE_D3D11
 #include <Windows.h>
 #include <intsafe.h>
 #include <dxgi.h>
 #include <d3d11_1.h>
+#endif
 
 #include <algorithm>
 #include <atomic>
+#include <vector>
 
+#if CAS_USE_D3D11
 #include <wil/com.h>
 
+// CasSetup ݂̂pACPUł̏ cas_cpu.cpp ɂ܂Ƃ߂
+// ffx_cas.h  static łȂ֐`邽߁AD3D11pȂꍇɊ܂߂ cas_core Ƃ̃Nŏd
+#include <math.h>
 #define A_CPU 1
 #include "ffx_a.h"
 #include "ffx_cas.h"
+#endif
+
+#include "cas_arena.h"
+#include "cas_cpu.h"
+#include "cas_metrics.h"
+#include "cas_numa.h"
+#include "cas_pipeline.h"
+#include "cas_probe.h"
+#include "cas_stats.h"
+#include "cas_trace.h"
 
 
+#ifdef _WIN32
 // O[oϐ
 HINSTANCE g_dll_handle;
+#endif
 
 
 // VLC Mediaplayerňݒ荀ڂ̖
@@ -22,20 +47,108 @@ HINSTANCE g_dll_handle;
 #define OPTION_KEY_ADAPTER "adapter"
 #define OPTION_KEY_SHARPNESS "sharpness"
 #define OPTION_KEY_FP16PREFER "fp16prefer"
+#define OPTION_KEY_QUALITY "quality"
+#define OPTION_KEY_IN_PLACE "in-place"
+#define OPTION_KEY_FRAMES "frames"
+#define OPTION_KEY_NUMA_NODE "numa-node"
+#define OPTION_KEY_TRACE_FILE "trace-file"
+#define OPTION_KEY_METRICS "metrics"
 static const char *const kFilterOptions[] =
 {
 	OPTION_KEY_ADAPTER,
 	OPTION_KEY_SHARPNESS,
 	OPTION_KEY_FP16PREFER,
+	OPTION_KEY_QUALITY,
+	OPTION_KEY_IN_PLACE,
+	OPTION_KEY_FRAMES,
+	OPTION_KEY_NUMA_NODE,
+	OPTION_KEY_TRACE_FILE,
+	OPTION_KEY_METRICS,
 	nullptr
 };
 static const char *kVarNameAdapter = OPTION_KEY_PREFIX OPTION_KEY_ADAPTER;
 static const char *kVarNameSharpness = OPTION_KEY_PREFIX OPTION_KEY_SHARPNESS;
 static const char *kVarNameFp16prefer = OPTION_KEY_PREFIX OPTION_KEY_FP16PREFER;
-
+static const char *kVarNameQuality = OPTION_KEY_PREFIX OPTION_KEY_QUALITY;
+static const char *kVarNameInPlace = OPTION_KEY_PREFIX OPTION_KEY_IN_PLACE;
+static const char *kVarNameFrames = OPTION_KEY_PREFIX OPTION_KEY_FRAMES;
+static const char *kVarNameNumaNode = OPTION_KEY_PREFIX OPTION_KEY_NUMA_NODE;
+static const char *kVarNameTraceFile = OPTION_KEY_PREFIX OPTION_KEY_TRACE_FILE;
+static const char *kVarNameMetrics = OPTION_KEY_PREFIX OPTION_KEY_METRICS;
+static const int kQualityValues[] = {kCasQualityBest, kCasQualityHigh, kCasQualityMedium, kCasQualityFast};
+static const char *const kQualityTexts[] = {"Best", "High", "Medium", "Fast"};
+
+#if CAS_USE_D3D11
 // 萔obt@̃TCY
 static const UINT kArgumentBufferSize = 32;
+#endif
+
+// iiK̐
+// iKオ邲Ƃ CAS.hlsl ̃tO CAS_BETTER_DIAGONALSACAS_GO_SLOWERACAS_SLOW ̏ɊOAyVF[_p
+// kPassthroughQuality łCASKpA̓sN`̂܂ܕԂ
+static const int kQualityLevels = kCasQualityLevels;
+static const int kPassthroughQuality = kQualityLevels;
+#if CAS_USE_D3D11
+static const char *const kShaderNames32[kQualityLevels] = {"CAS32", "CAS32_Q1", "CAS32_Q2", "CAS32_Q3"};
+static const char *const kShaderNames16[kQualityLevels] = {"CAS16", "CAS16_Q1", "CAS16_Q2", "CAS16_Q3"};
+#endif
+
+// Ԃ̈ړςt[Ԋuɐ߂銄 kDowngradeLoad 𒴂Ԃ kDowngradeFrames ƕi1iKA
+// kUpgradeLoad Ԃ kUpgradeFrames ƕi1iKグ
+static const double kDowngradeLoad = 0.6;
+static const double kUpgradeLoad = 0.3;
+static const int kDowngradeFrames = 8;
+static const int kUpgradeFrames = 120;
+
+// t[Pʂŕɏꍇ́Aɏt[̏
+static const int kMaxFramesInFlight = 16;
+
+// iKƂ̏Ԃ̓vJϐ
+// ϐ cas-stats-<iK>-<> ŁAl̓}CNb (count ͉)
+// ϐ̍XV̓bN邽߁AFilter ł͓v݂̂XVAϐւ kStatsPublishIntervalMs Ƃɏ
+#define STATS_VAR_PREFIX OPTION_KEY_PREFIX "stats-"
+static const char *const kStatsFieldNames[] = {"count", "sum", "min", "max", "p50", "p99"};
+static const int kStatsFields = sizeof (kStatsFieldNames) / sizeof (kStatsFieldNames[0]);
+static const int kStatsPublishIntervalMs = 1000;
+
+// Filter ŋNُ
+// t[ƂɃOƁAُȃXg[ł͖b\s𐮌`ďƂɂȂ邽߁A񐔂̂ݐ
+// ŏ1͂ɁAȍ~ kEventReportIntervalMs ƂɁÅԂ̉񐔂1sɂ܂Ƃ߂ď
+enum FilterEvent
+{
+	kEventNullPicture = 0,
+	kEventInvalidPicture,
+	kEventNoOutputPicture,
+	kEventUploadFailed,
+	kEventReadbackFailed,
+	kEventScratchFailed,
+	kEventSharedPicture,
+	kFilterEvents
+};
+static const char *const kFilterEventNames[kFilterEvents] =
+{
+	"null input picture",
+	"invalid picture",
+	"can not prepare new picture",
+	"failed CopyPictureToDynamicTexture",
+	"failed CopyStagingTextureToPicture",
+	"can not allocate CPU scratch",
+	"input picture is shared, not filtered in place",
+};
+// Prometheus ̃xlɗp閼O
+static const char *const kFilterEventKeys[kFilterEvents] =
+{
+	"null_picture",
+	"invalid_picture",
+	"no_output_picture",
+	"upload_failed",
+	"readback_failed",
+	"scratch_failed",
+	"shared_picture",
+};
+static const int kEventReportIntervalMs = 10000;
 
+#ifdef _WIN32
 // VLC̊ewb_Ŏgp邽߁A`Ă
 typedef SSIZE_T ssize_t;
 
@@ -45,6 +158,7 @@ int poll(struct pollfd *fds, unsigned nfds, int timeout)
 	RaiseException(STATUS_NONCONTINUABLE_EXCEPTION, EXCEPTION_SOFTWARE_ORIGINATE, 0, nullptr);
 	return 0;
 }
+#endif
 
 // vlc_plugin.h ŎQƂ邽߁AOɒ`Ă
 #define MODULE_STRING ("libcas_plugin")
@@ -56,8 +170,17 @@ int poll(struct pollfd *fds, unsigned nfds, int timeout)
 #include <vlc_variables.h>
 
 
+// t[Pʂŕɏꍇ́ÃsN`̑g
+// output  nullptr ̏ꍇ͏Ainput ̂܂ܕԂ
+struct CasFrame
+{
+	picture_t *input;
+	picture_t *output;
+};
+
 struct filter_sys_t
 {
+#if CAS_USE_D3D11
 	ID3D11Device *device_;
 	ID3D11DeviceContext *device_context_;
 	ID3D11Texture2D *dynamic_texture_; // VF[_́AɃsN`Rs[
@@ -65,10 +188,36 @@ struct filter_sys_t
 	ID3D11Texture2D *staging_texture_; // VF[_o͂ɃRs[ĂCPUœǂݎAo̓sN`ɃRs[
 	ID3D11Buffer *argumanet_buffer_; // VF[_́AAAV[vlXl^
 	ID3D11UnorderedAccessView *uav_; // CSSetUnorderedAccessViewsUAV̕ێs|̋Lq̂ŁAꉞۑĂ
-	ID3D11ComputeShader *cas_shader_;
+	ID3D11ComputeShader *cas_shaders_[kQualityLevels]; // iiKƂ̃VF[_
+#endif
+	CasCpuEngine *cpu_engine_; // D3D11𗘗płȂꍇɗpApłꍇnullptr
+	bool in_place_; // CPUŏꍇA̓sN`㏑ĕԂ
+	CasCpuPipeline *pipeline_; // CPUŃt[Pʂŕɏꍇ̂
+	std::vector<CasFrame> frames_; // pCvC̘gƂ̏̃sN`AɏzĎg
+	int next_frame_; // ɓsN`u frames_ ̈ʒu
+	CasArena arena_; // CPUŏꍇ̍Ɨ̈AOpen ł܂Ƃ߂ĊmۂAFilter ł̓q[vmۂȂ
+	int numa_node_; // [J[ƍƗ̈uNUMAm[hȀꍇ͎w肵Ȃ
 	float width_;
 	float height_;
 	std::atomic<float> sharpness_;
+	std::atomic<int> requested_quality_; // ݒ荀ڂ̕ύXŎw肳ꂽiiKAFilterŔf܂ł-1ȊO
+	int base_quality_; // ݒ荀ڂŎw肳ꂽiiKAׂƂ̒iK܂Ŗ߂
+	int quality_; // ݂̕iiK
+	mtime_t frame_interval_; // t[[g狁߂t[ԊuAsȏꍇ0
+	mtime_t last_date_; // O̓̓sN`̕\
+	mtime_t average_elapsed_; // 1t[̏Ԃ̈ړ
+	int overload_frames_; // ԂԂt[
+	int underload_frames_; // ԂZԂt[
+	CasStageStats stats_[kCasStages]; // iKƂ̏ (}CNb)
+	mtime_t stats_published_; // vϐɏ
+	uint64_t frame_index_; // Filter Ă΂ꂽ񐔁Ag[XŃt[ʂ邽߂ɗp
+	bool tracing_; // ̃tB^ CasTraceOpen Ă
+	std::atomic<uint64_t> event_counts_[kFilterEvents]; // ُ킲Ƃ̗݌v̉
+	uint64_t reported_counts_[kFilterEvents]; // Oɏ_ event_counts_
+	mtime_t events_reported_; // ُOɏAĂȂꍇ VLC_TS_INVALID
+	std::atomic<int> exported_quality_; // quality_ ̎ʂAJp̃Xbhǂ
+	CasMetricsSource metrics_source_; // Prometheus ̌`ŌJ铝v
+	bool metrics_; // ̃tB^ CasMetricsStart Ă
 };
 
 
@@ -76,18 +225,44 @@ struct filter_sys_t
 int Open(vlc_object_t *obj);
 void Close(vlc_object_t *obj);
 picture_t *Filter(filter_t *filter, picture_t *input_picture);
+void Flush(filter_t *filter);
 int VariableChangeCallback(vlc_object_t *obj, char const *variable_name, vlc_value_t old_value, vlc_value_t new_value, void *data);
 
 // R[obN֐
 void VlcLog(vlc_object_t *obj, vlc_log_type prio, const char *format, ...);
+#if CAS_USE_D3D11
+bool OpenD3D11(filter_t *filter);
 bool SetupCom();
 bool CreateComputeShader(ID3D11ComputeShader **shader, ID3D11Device *device, HMODULE module, const char *resource_type, const char *resource_name);
+bool CreateComputeShaders(wil::com_ptr<ID3D11ComputeShader> (&shaders)[kQualityLevels], ID3D11Device *device, HMODULE module, const char *const (&resource_names)[kQualityLevels]);
+#endif
+bool SetupScratch(filter_t *filter);
 bool ValidatePicture(filter_t *filter, picture_t *input_picture);
+#if CAS_USE_D3D11
 bool CopyPictureToDynamicTexture(filter_t *filter, picture_t *input_picture);
 void Cas(filter_t *filter, picture_t *input_picture);
 void CopyDefaultTextureToStagingTexture(filter_t *filter);
 bool CopyStagingTextureToPicture(filter_t *filter, picture_t *output_picture);
-
+#endif
+picture_t *FilterFrames(filter_t *filter, picture_t *input_picture, mtime_t start, mtime_t interval);
+picture_t *ReceiveFrame(filter_t *filter, bool wait);
+picture_t *ReceiveFrames(filter_t *filter, picture_t *first, bool wait);
+bool CasCpu(filter_t *filter, picture_t *input_picture, picture_t *output_picture);
+bool CasCpuInPlace(filter_t *filter, picture_t *picture);
+bool PictureWritable(const picture_t *picture);
+void SetQuality(filter_t *filter, int quality);
+mtime_t FrameInterval(filter_t *filter, picture_t *input_picture);
+void UpdateQuality(filter_t *filter, mtime_t elapsed, mtime_t interval);
+void FinishFrame(filter_t *filter, mtime_t start, mtime_t interval);
+mtime_t RecordStage(filter_t *filter, int stage, mtime_t start);
+void StatsVariableName(char (&name)[64], int stage, int field);
+void CreateStatsVariables(filter_t *filter);
+void DestroyStatsVariables(filter_t *filter);
+void PublishStats(filter_t *filter);
+void CountEvent(filter_t *filter, int event);
+void ReportEvents(filter_t *filter, bool force);
+
+#ifdef _WIN32
 // DLL Gg|Cg
 // DLL̃\[Xǂނ߂ɁADLL̃nhO[oϐɕۑ
 BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD fdwReason, LPVOID lpvReserved)
@@ -108,28 +283,12 @@ BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD fdwReason, LPVOID lpvReserved)
 
 	return TRUE;
 }
+#endif
 
 int Open(vlc_object_t *obj)
 {
 	filter_t *filter = reinterpret_cast<filter_t *>(obj);
-	wil::com_ptr<IDXGIFactory1> dxgi_factory;
-	wil::com_ptr<IDXGIAdapter1> adapter;
-	wil::com_ptr_nothrow<ID3D11Device> device;
-	wil::com_ptr<ID3D11DeviceContext> device_context;
-	wil::com_ptr<ID3D11Texture2D> dynamic_texture;
-	wil::com_ptr<ID3D11Texture2D> default_texture;
-	wil::com_ptr<ID3D11Texture2D> staging_texture;
-	wil::com_ptr<ID3D11ComputeShader> cas_shader;
-	wil::com_ptr<ID3D11Buffer> argumanet_buffer;
-	wil::com_ptr<ID3D11ShaderResourceView> srv;
-	wil::com_ptr<ID3D11UnorderedAccessView> uav;
-
 
-	if (!SetupCom())
-	{
-		VlcLog(obj, VLC_MSG_ERR, "Failed COM setup.");
-		return VLC_EGENERIC;
-	}
 
 	// chroma format priority (auto)
 	// VLC_CODEC_D3D11_OPAQUE
@@ -153,15 +312,441 @@ int Open(vlc_object_t *obj)
 		return VLC_EGENERIC;
 	}
 
+	// ݒ荀ڂ𗘗p邽߂̏
+	config_ChainParse(obj, OPTION_KEY_PREFIX, kFilterOptions, filter->p_cfg);
+
+	float sharpness = var_GetFloat(obj, kVarNameSharpness);
+	sharpness = std::clamp(sharpness, 0.0f, 1.0f);
+
+	int quality = static_cast<int>(var_GetInteger(obj, kVarNameQuality));
+	quality = std::clamp(quality, 0, kQualityLevels - 1);
+
+	// ďoւ̏
+	filter->p_sys = new(std::nothrow) filter_sys_t();
+	if (!filter->p_sys)
+	{
+		VlcLog(obj, VLC_MSG_ERR, "Can not allocate filter_sys_t");
+		return VLC_ENOMEM;
+	}
+
+	// D3D11𗘗płȂꍇACPUŏ
+#if CAS_USE_D3D11
+	bool use_cpu = !OpenD3D11(filter);
+	if (use_cpu)
+		VlcLog(obj, VLC_MSG_WARN, "D3D11 is not available, falling back to CPU");
+#else
+	bool use_cpu = true;
+#endif
+
+	// ݂Ȃm[hw肳ꂽꍇ́Am[hw肹ɏ
+	int numa_node = static_cast<int>(var_GetInteger(obj, kVarNameNumaNode));
+	if (use_cpu && CasNumaNodeCount() <= numa_node)
+	{
+		VlcLog(obj, VLC_MSG_WARN, "NUMA node is out of range, ignored");
+		numa_node = -1;
+	}
+	filter->p_sys->numa_node_ = std::max(-1, numa_node);
+
+	// ̃t[𓯎ɏꍇAet[Xbh̓pCvC
+	// t[̏ CasCpuEngine pȂ߁AXbhȂ̂
+	int frames = std::clamp(static_cast<int>(var_GetInteger(obj, kVarNameFrames)), 1, kMaxFramesInFlight);
+	if (use_cpu)
+	{
+		filter->p_sys->cpu_engine_ = CasCpuCreateOnNode(1 < frames ? 1 : 0, filter->p_sys->numa_node_);
+		if (!filter->p_sys->cpu_engine_)
+		{
+			VlcLog(obj, VLC_MSG_ERR, "Failed CasCpuCreate");
+			delete filter->p_sys;
+			return VLC_ENOMEM;
+		}
+	}
+
+	if (use_cpu && 1 < frames)
+	{
+		filter->p_sys->pipeline_ = CasCpuPipelineCreateOnNode(frames, 0, filter->p_sys->numa_node_);
+		try
+		{
+			filter->p_sys->frames_.resize(frames);
+		}
+		catch (...)
+		{
+			CasCpuPipelineDestroy(filter->p_sys->pipeline_);
+			filter->p_sys->pipeline_ = nullptr;
+		}
+
+		if (!filter->p_sys->pipeline_)
+		{
+			VlcLog(obj, VLC_MSG_ERR, "Failed CasCpuPipelineCreate");
+			CasCpuDestroy(filter->p_sys->cpu_engine_);
+			delete filter->p_sys;
+			return VLC_ENOMEM;
+		}
+	}
+	filter->p_sys->next_frame_ = 0;
+
+	// Ɨ̈mۂłȂꍇ́AeGW̓rŊmۂ
+	if (use_cpu && !SetupScratch(filter))
+		VlcLog(obj, VLC_MSG_WARN, "Can not allocate scratch arena");
+
+	filter->p_sys->width_ = static_cast<float>(filter->fmt_in.video.i_width);
+	filter->p_sys->height_ = static_cast<float>(filter->fmt_in.video.i_height);
+	filter->p_sys->sharpness_ = sharpness;
+	filter->p_sys->in_place_ = var_GetBool(obj, kVarNameInPlace);
+	if (filter->p_sys->pipeline_ && filter->p_sys->in_place_)
+	{
+		VlcLog(obj, VLC_MSG_WARN, "In-place is ignored when processing multiple frames in parallel");
+		filter->p_sys->in_place_ = false;
+	}
+	filter->p_sys->requested_quality_ = -1;
+	filter->p_sys->base_quality_ = quality;
+	filter->p_sys->frame_interval_ = 0;
+	if (filter->fmt_in.video.i_frame_rate && filter->fmt_in.video.i_frame_rate_base)
+		filter->p_sys->frame_interval_ = CLOCK_FREQ * filter->fmt_in.video.i_frame_rate_base / filter->fmt_in.video.i_frame_rate;
+	filter->p_sys->last_date_ = VLC_TS_INVALID;
+	filter->p_sys->events_reported_ = VLC_TS_INVALID;
+	filter->p_sys->average_elapsed_ = 0;
+	SetQuality(filter, quality);
+	CreateStatsVariables(filter);
+
+	// g[X͐ݒ肵ꍇ̂݋L^AvZX̃tB^ׂ͂ēt@CɋL^
+	char *trace_file = var_GetString(obj, kVarNameTraceFile);
+	if (trace_file && *trace_file)
+	{
+		filter->p_sys->tracing_ = CasTraceOpen(trace_file);
+		if (!filter->p_sys->tracing_)
+			VlcLog(obj, VLC_MSG_WARN, "Can not open trace file %s", trace_file);
+	}
+	free(trace_file);
+
+	// g[X̓vZXŋL邽߁AL^JtB^݂̂ԂL^
+	if (filter->p_sys->tracing_)
+	{
+		if (filter->p_sys->cpu_engine_)
+			CasCpuSetTracing(filter->p_sys->cpu_engine_, true);
+		if (filter->p_sys->pipeline_)
+			CasCpuPipelineSetTracing(filter->p_sys->pipeline_, true);
+	}
+
+	// v͏ɓo^AvZX̂ꂩ̃tB^JJnƁAׂẴtB^̓vJ
+	CasMetricsSource *source = &filter->p_sys->metrics_source_;
+	source->backend = filter->p_sys->cpu_engine_ ? "cpu" : "d3d11";
+	source->width = static_cast<int>(filter->fmt_in.video.i_width);
+	source->height = static_cast<int>(filter->fmt_in.video.i_height);
+	source->stages = filter->p_sys->stats_;
+	source->events = filter->p_sys->event_counts_;
+	source->event_names = kFilterEventKeys;
+	source->event_count = kFilterEvents;
+	source->quality = &filter->p_sys->exported_quality_;
+	if (!CasMetricsRegister(source))
+		VlcLog(obj, VLC_MSG_WARN, "Can not register metrics");
+
+	char *metrics = var_GetString(obj, kVarNameMetrics);
+	if (metrics && *metrics)
+	{
+		filter->p_sys->metrics_ = CasMetricsStart(metrics);
+		if (!filter->p_sys->metrics_)
+			VlcLog(obj, VLC_MSG_WARN, "Can not export metrics to %s", metrics);
+	}
+	free(metrics);
+
+	filter->pf_video_filter = Filter;
+	filter->pf_flush = Flush;
+
+	var_AddCallback(obj, kVarNameSharpness, VariableChangeCallback, nullptr);
+	var_AddCallback(obj, kVarNameQuality, VariableChangeCallback, nullptr);
+
+	VlcLog(obj, VLC_MSG_INFO, "Open success");
+
+	return VLC_SUCCESS;
+}
+
+void Close(vlc_object_t *obj)
+{
+	filter_t *filter = reinterpret_cast<filter_t *>(obj);
+
+	// Close ̌ɓn͖߁ÃsN`͏Î҂ĉ
+	// Xg[̏IŗƂȂ悤AFilter ͏̏IsN`sxԂANULL ŌĂ΂ꂽꍇׂ͂ĕԂ
+	if (filter->p_sys->pipeline_)
+	{
+		int dropped = 0;
+		picture_t *picture = ReceiveFrames(filter, nullptr, true);
+		while (picture)
+		{
+			picture_t *next = picture->p_next;
+			picture->p_next = nullptr;
+			picture_Release(picture);
+			picture = next;
+			++dropped;
+		}
+		if (dropped)
+			VlcLog(obj, VLC_MSG_WARN, "Dropped %d pictures still in the pipeline at close", dropped);
+	}
+
+	// Filter ̓rōƗ̈mۂꍇ́AOpen ŗpӂƗ̈悪ĂȂ
+	if (filter->p_sys->cpu_engine_)
+	{
+		uint64_t allocations = CasCpuScratchAllocations(filter->p_sys->cpu_engine_);
+		if (filter->p_sys->pipeline_)
+			allocations += CasCpuPipelineScratchAllocations(filter->p_sys->pipeline_);
+		if (allocations)
+			VlcLog(obj, VLC_MSG_WARN, "Scratch was allocated %llu times while filtering", static_cast<unsigned long long>(allocations));
+	}
+
+	if (filter->p_sys->pipeline_)
+	{
+		CasCpuPipelineDestroy(filter->p_sys->pipeline_);
+	}
+
+	if (filter->p_sys->cpu_engine_)
+	{
+		CasCpuDestroy(filter->p_sys->cpu_engine_);
+		CasArenaDestroy(&filter->p_sys->arena_);
+	}
+#if CAS_USE_D3D11
+	else
+	{
+		filter->p_sys->device_->Release();
+		filter->p_sys->device_context_->Release();
+		filter->p_sys->dynamic_texture_->Release();
+		filter->p_sys->default_texture_->Release();
+		filter->p_sys->staging_texture_->Release();
+		for (int i=0; i<kQualityLevels; ++i)
+			filter->p_sys->cas_shaders_[i]->Release();
+		filter->p_sys->argumanet_buffer_->Release();
+		filter->p_sys->uav_->Release();
+	}
+#endif
+
+	var_DelCallback(obj, kVarNameSharpness, VariableChangeCallback, nullptr);
+	var_DelCallback(obj, kVarNameQuality, VariableChangeCallback, nullptr);
+	DestroyStatsVariables(filter);
+	ReportEvents(filter, true);
+
+	CasMetricsUnregister(&filter->p_sys->metrics_source_);
+	if (filter->p_sys->metrics_)
+		CasMetricsStop();
+
+	// [J[ׂĎ~߂ĂAc̋L^
+	if (filter->p_sys->tracing_)
+		CasTraceClose();
+
+	VlcLog(obj, VLC_MSG_INFO, "Close success");
+
+	delete filter->p_sys;
+}
+
+picture_t *Filter(filter_t *filter, picture_t *input_picture)
+{
+	picture_t *output_picture;
+
+
+	// ̓sN`ꍇ
+	// t[Pʂŕɏꍇ́ÃsN`ׂđ҂Ȁ p_next łȂŕԂ
+	if (!input_picture)
+	{
+		if (filter->p_sys->pipeline_)
+			return ReceiveFrames(filter, nullptr, true);
+
+		CountEvent(filter, kEventNullPicture);
+		return nullptr;
+	}
+
+	mtime_t start = mdate();
+	mtime_t interval = FrameInterval(filter, input_picture);
+	++filter->p_sys->frame_index_;
+
+	// iiḰACASKpȂiK܂߂āA̎_̂̂n
+	CAS_PROBE6(frame__start, filter->p_sys->frame_index_, filter->fmt_in.video.i_width, filter->fmt_in.video.i_height,
+		CAS_PROBE_SHARPNESS(filter->p_sys->sharpness_.load()), filter->p_sys->quality_, !!filter->p_sys->cpu_engine_);
+
+	// iiK̐ݒ荀ڂύXꂽꍇA̒iK蒼
+	int requested_quality = filter->p_sys->requested_quality_.exchange(-1);
+	if (0 <= requested_quality)
+	{
+		filter->p_sys->base_quality_ = requested_quality;
+		SetQuality(filter, requested_quality);
+	}
+
+	// t[Pʂŕɏꍇ
+	if (filter->p_sys->pipeline_)
+		return FilterFrames(filter, input_picture, start, interval);
+
+	// ׂCASKpȂiK܂ŕiĂꍇA̓sN`̂܂ܕԂ
+	if (kPassthroughQuality == filter->p_sys->quality_)
+	{
+		FinishFrame(filter, start, interval);
+		return input_picture;
+	}
+
+	// ̓sN`̃tH[}bgTCYsȏꍇA̓sN`̂܂ܕԂ
+	// o̓sN`̊蓖ĂƁȂŜւ̃Rs[
+	if (!ValidatePicture(filter, input_picture))
+	{
+		CountEvent(filter, kEventInvalidPicture);
+		return input_picture;
+	}
+
+	// CPUł̏ŏꍇAo̓sN`蓖Ăɓ̓sN`㏑ĕԂ
+	// ̓sN`𑼂ɎQƂ (Qƃt[ƂĕێfR[_Ȃ) ꍇƁAƗ̈mۂłȂꍇ́Ao̓sN`ɏʏ̏s
+	if (filter->p_sys->cpu_engine_ && filter->p_sys->in_place_ && !PictureWritable(input_picture))
+	{
+		CountEvent(filter, kEventSharedPicture);
+	}
+	else if (filter->p_sys->cpu_engine_ && filter->p_sys->in_place_)
+	{
+		mtime_t compute_start = mdate();
+		if (CasCpuInPlace(filter, input_picture))
+		{
+			RecordStage(filter, kCasStageCompute, compute_start);
+			FinishFrame(filter, start, interval);
+			return input_picture;
+		}
+	}
+
+	// o̓sN`̊蓖Ăs
+	output_picture = filter_NewPicture(filter);
+	if (!output_picture)
+	{
+		CountEvent(filter, kEventNoOutputPicture);
+		picture_Release(input_picture);
+		return nullptr;
+	}
+
+	// CPUŏꍇ
+	// ̓sN` p[0] 𒼐ړǂ݁Ao̓sN` p[0] ɒڏ߁Aef̓ǂݏ1񂸂ōς
+	// GPȔ̂悤ȁAeNX`ւ̃Rs[Ɠǂݖ߂͍sȂ
+	if (filter->p_sys->cpu_engine_)
+	{
+		// Ɨ̈mۂłȂꍇAo̓sN`ɓ̓sN`Rs[Ԃ
+		mtime_t compute_start = mdate();
+		if (!CasCpu(filter, input_picture, output_picture))
+		{
+			CountEvent(filter, kEventScratchFailed);
+			picture_Copy(output_picture, input_picture);
+			picture_Release(input_picture);
+			return output_picture;
+		}
+		RecordStage(filter, kCasStageCompute, compute_start);
+
+		picture_CopyProperties(output_picture, input_picture);
+		picture_Release(input_picture);
+
+		FinishFrame(filter, start, interval);
+
+		return output_picture;
+	}
+
+#if CAS_USE_D3D11
+	// picture̓edynamic textureփRs[邱Ƃ݂
+	// sꍇAo̓sN`ɓ̓sN`Rs[Ԃ
+	mtime_t stage_start = mdate();
+	if (!CopyPictureToDynamicTexture(filter, input_picture))
+	{
+		CountEvent(filter, kEventUploadFailed);
+		picture_Copy(output_picture, input_picture);
+		picture_Release(input_picture);
+		return output_picture;
+	}
+
+	RecordStage(filter, kCasStageUpload, stage_start);
+
+	// dynamic textureǂ݁ACAS̏ʂdefault textureɏ
+	// GPUւ̖߂̔ŝ݂ŁAGPUł̏Ԃ͎̓ǂݖ߂ Map ҂ԂɊ܂܂
+	stage_start = mdate();
+	Cas(filter, input_picture);
+
+	// default texture̓estaging textureփRs[
+	CopyDefaultTextureToStagingTexture(filter);
+	RecordStage(filter, kCasStageCompute, stage_start);
+
+	// staging texture̓eoutput_pictureփRs[
+	// sꍇAo̓sN`ɓ̓sN`Rs[Ԃ
+	stage_start = mdate();
+	if (!CopyStagingTextureToPicture(filter, output_picture))
+	{
+		CountEvent(filter, kEventReadbackFailed);
+		picture_Copy(output_picture, input_picture);
+		picture_Release(input_picture);
+		return output_picture;
+	}
+
+	RecordStage(filter, kCasStageReadback, stage_start);
+
+	picture_CopyProperties(output_picture, input_picture);
+	picture_Release(input_picture);
+
+	// GPȔstaging textureMapő҂Ă邽߁A܂ł̎ԂCAS̏ԂƂ
+	FinishFrame(filter, start, interval);
+#endif
+
+	return output_picture;
+}
+
+// ̃sN`ׂĔj
+// V[NȂǂŌĂ΂A܂ł̃sN`͕\Ȃ߁AԂɔj
+// ̃sN`̓[J[ǂݏĂ邽߁AI܂ő҂Ă
+void Flush(filter_t *filter)
+{
+	if (!filter->p_sys->pipeline_)
+		return;
+
+	while (picture_t *picture = ReceiveFrame(filter, true))
+		picture_Release(picture);
+}
+
+int VariableChangeCallback(vlc_object_t *obj, char const *variable_name, vlc_value_t old_value, vlc_value_t new_value, void *data)
+{
+	filter_t *filter = reinterpret_cast<filter_t *>(obj);
+	filter_sys_t *sys = reinterpret_cast<filter_sys_t *>(filter->p_sys);
+
+	// CPUŏꍇAɉd݂̕\͎̃t[̏̊Jnɍ蒼
+	// ō蒼Ə̃t[Ƌ邽߁Al̕ۑ̂ݍs
+	if (0 == strcmp(kVarNameSharpness, variable_name))
+		sys->sharpness_.store(new_value.f_float);
+	else if (0 == strcmp(kVarNameQuality, variable_name))
+		sys->requested_quality_.store(std::clamp(static_cast<int>(new_value.i_int), 0, kQualityLevels - 1));
+
+	return VLC_SUCCESS;
+}
+
+void VlcLog(vlc_object_t *obj, vlc_log_type prio, const char *format, ...)
+{
+	va_list ap;
+
+	va_start(ap, format);
+	vlc_vaLog(obj, prio, vlc_module_name, nullptr, 0, nullptr, format, ap);
+	va_end(ap);
+}
+
+#if CAS_USE_D3D11
+bool OpenD3D11(filter_t *filter)
+{
+	vlc_object_t *obj = VLC_OBJECT(filter);
+	wil::com_ptr<IDXGIFactory1> dxgi_factory;
+	wil::com_ptr<IDXGIAdapter1> adapter;
+	wil::com_ptr_nothrow<ID3D11Device> device;
+	wil::com_ptr<ID3D11DeviceContext> device_context;
+	wil::com_ptr<ID3D11Texture2D> dynamic_texture;
+	wil::com_ptr<ID3D11Texture2D> default_texture;
+	wil::com_ptr<ID3D11Texture2D> staging_texture;
+	wil::com_ptr<ID3D11ComputeShader> cas_shaders[kQualityLevels];
+	wil::com_ptr<ID3D11Buffer> argumanet_buffer;
+	wil::com_ptr<ID3D11ShaderResourceView> srv;
+	wil::com_ptr<ID3D11UnorderedAccessView> uav;
+
+
+	if (!SetupCom())
+	{
+		VlcLog(obj, VLC_MSG_ERR, "Failed COM setup.");
+		return false;
+	}
+
 	if (FAILED(CreateDXGIFactory1(IID_PPV_ARGS(&dxgi_factory))))
 	{
 		VlcLog(obj, VLC_MSG_ERR, "Failed CreateDXGIFactory1");
-		return VLC_EGENERIC;
+		return false;
 	}
 
-	// ݒ荀ڂ𗘗p邽߂̏
-	config_ChainParse(obj, OPTION_KEY_PREFIX, kFilterOptions, filter->p_cfg);
-
 	UINT adapter_index = static_cast<UINT>(var_GetInteger(obj, kVarNameAdapter));
 
 	dxgi_factory->EnumAdapters1(adapter_index, &adapter);
@@ -176,7 +761,7 @@ int Open(vlc_object_t *obj)
 		if (FAILED(adapter->GetDesc1(&desc1)))
 		{
 			VlcLog(obj, VLC_MSG_ERR, "Failed GetDesc1");
-			return VLC_EGENERIC;
+			return false;
 		}
 
 		// w肵A_v^\tgEFAA_v^̏ꍇ̃foCXIuWFNg
@@ -194,7 +779,7 @@ int Open(vlc_object_t *obj)
 				nullptr)))
 			{
 				VlcLog(obj, VLC_MSG_ERR, "Failed D3D11CreateDevice (valid adapter)");
-				return VLC_EGENERIC;
+				return false;
 			}
 
 			VlcLog(obj, VLC_MSG_INFO, "D3D11CreateDevice (valid adapter)");
@@ -214,7 +799,7 @@ int Open(vlc_object_t *obj)
 				nullptr)))
 			{
 				VlcLog(obj, VLC_MSG_ERR, "Failed D3D11CreateDevice (WARP adapter)");
-				return VLC_EGENERIC;
+				return false;
 			}
 
 			VlcLog(obj, VLC_MSG_INFO, "D3D11CreateDevice (WARP adapter)");
@@ -235,7 +820,7 @@ int Open(vlc_object_t *obj)
 			nullptr)))
 		{
 			VlcLog(obj, VLC_MSG_ERR, "Failed D3D11CreateDevice (default adapter)");
-			return VLC_EGENERIC;
+			return false;
 		}
 
 		VlcLog(obj, VLC_MSG_INFO, "D3D11CreateDevice (default adapter)");
@@ -257,7 +842,7 @@ int Open(vlc_object_t *obj)
 	if (FAILED(device->CreateTexture2D(&texture_desc, nullptr, &dynamic_texture)))
 	{
 		VlcLog(obj, VLC_MSG_ERR, "Failed CreateTexture2D (dynamic texture)");
-		return VLC_EGENERIC;
+		return false;
 	}
 
 	texture_desc.Usage = D3D11_USAGE_DEFAULT;
@@ -266,7 +851,7 @@ int Open(vlc_object_t *obj)
 	if (FAILED(device->CreateTexture2D(&texture_desc, nullptr, &default_texture)))
 	{
 		VlcLog(obj, VLC_MSG_ERR, "Failed CreateTexture2D (default texture)");
-		return VLC_EGENERIC;
+		return false;
 	}
 
 	texture_desc.Usage = D3D11_USAGE_STAGING;
@@ -276,14 +861,14 @@ int Open(vlc_object_t *obj)
 	if (FAILED(device->CreateTexture2D(&texture_desc, nullptr, &staging_texture)))
 	{
 		VlcLog(obj, VLC_MSG_ERR, "Failed CreateTexture2D (staging texture)");
-		return VLC_EGENERIC;
+		return false;
 	}
 
-	// VF[_IuWFNg𐶐
+	// VF[_IuWFNgiiKƂɐ
 	// Ƃ肠FP32ł𐶐AFP16łD悷w肪FP16łɌ
-	CreateComputeShader(&cas_shader, device.get(), g_dll_handle, "SHADER", "CAS32");
+	bool cas_shaders_created = CreateComputeShaders(cas_shaders, device.get(), g_dll_handle, kShaderNames32);
 
-	if (var_GetBool(obj, kVarNameFp16prefer) || !cas_shader)
+	if (var_GetBool(obj, kVarNameFp16prefer) || !cas_shaders_created)
 	{
 		wil::com_ptr<ID3D11Device1> device1;
 
@@ -296,18 +881,21 @@ int Open(vlc_object_t *obj)
 			if (SUCCEEDED(device1->CheckFeatureSupport(D3D11_FEATURE_SHADER_MIN_PRECISION_SUPPORT, &min_precision, sizeof (D3D11_FEATURE_DATA_SHADER_MIN_PRECISION_SUPPORT)))
 				&& (D3D11_SHADER_MIN_PRECISION_16_BIT & min_precision.AllOtherShaderStagesMinPrecision))
 			{
-				wil::com_ptr<ID3D11ComputeShader> cas16_shader;
+				wil::com_ptr<ID3D11ComputeShader> cas16_shaders[kQualityLevels];
 
-				if (CreateComputeShader(&cas16_shader, device1.get(), g_dll_handle, "SHADER", "CAS16"))
-					cas_shader = cas16_shader;
+				if (CreateComputeShaders(cas16_shaders, device1.get(), g_dll_handle, kShaderNames16))
+				{
+					std::swap(cas_shaders, cas16_shaders);
+					cas_shaders_created = true;
+				}
 			}
 		}
 	}
 
-	if (!cas_shader)
+	if (!cas_shaders_created)
 	{
 		VlcLog(obj, VLC_MSG_ERR, "Failed CreateComputeShader (CAS32 and CAS16)");
-		return VLC_EGENERIC;
+		return false;
 	}
 
 	//萔obt@̐
@@ -323,7 +911,7 @@ int Open(vlc_object_t *obj)
 		if (FAILED(device->CreateBuffer(&desc, nullptr, &argumanet_buffer)))
 		{
 			VlcLog(obj, VLC_MSG_ERR, "Failed CreateBuffer (argument buffer)");
-			return VLC_EGENERIC;
+			return false;
 		}
 	}
 
@@ -338,7 +926,7 @@ int Open(vlc_object_t *obj)
 		if (FAILED(device->CreateShaderResourceView(dynamic_texture.get(), &desc, &srv)))
 		{
 			VlcLog(obj, VLC_MSG_ERR, "Failed CreateShaderResourceView");
-			return VLC_EGENERIC;
+			return false;
 		}
 	}
 
@@ -352,7 +940,7 @@ int Open(vlc_object_t *obj)
 		if (FAILED(device->CreateUnorderedAccessView(default_texture.get(), &desc, &uav)))
 		{
 			VlcLog(obj, VLC_MSG_ERR, "Failed CreateUnorderedAccessView");
-			return VLC_EGENERIC;
+			return false;
 		}
 	}
 
@@ -360,7 +948,7 @@ int Open(vlc_object_t *obj)
 
 	//CS, CB, SRV, UAV̐ݒ
 	{
-		device_context->CSSetShader(cas_shader.get(), nullptr, 0);
+		device_context->CSSetShader(cas_shaders[0].get(), nullptr, 0);
 
 		ID3D11Buffer *constant_buffers[] = {argumanet_buffer.get()};
 		device_context->CSSetConstantBuffers(0, 1, constant_buffers);
@@ -372,139 +960,17 @@ int Open(vlc_object_t *obj)
 		device_context->CSSetUnorderedAccessViews(0, 1, uavs, nullptr);
 	}
 
-	float sharpness = var_GetFloat(obj, kVarNameSharpness);
-	sharpness = std::clamp(sharpness, 0.0f, 1.0f);
-
-	// ďoւ̏
-	filter->p_sys = new(std::nothrow) filter_sys_t;
-	if (!filter->p_sys)
-	{
-		VlcLog(obj, VLC_MSG_ERR, "Can not allocate filter_sys_t");
-		return VLC_ENOMEM;
-	}
-
 	filter->p_sys->device_ = device.detach();
 	filter->p_sys->device_context_ = device_context.detach();
 	filter->p_sys->dynamic_texture_ = dynamic_texture.detach();
 	filter->p_sys->default_texture_ = default_texture.detach();
 	filter->p_sys->staging_texture_ = staging_texture.detach();
-	filter->p_sys->cas_shader_ = cas_shader.detach();
+	for (int i=0; i<kQualityLevels; ++i)
+		filter->p_sys->cas_shaders_[i] = cas_shaders[i].detach();
 	filter->p_sys->argumanet_buffer_ = argumanet_buffer.detach();
 	filter->p_sys->uav_ = uav.detach();
-	filter->p_sys->width_ = static_cast<AF1>(filter->fmt_in.video.i_width);
-	filter->p_sys->height_ = static_cast<AF1>(filter->fmt_in.video.i_height);
-	filter->p_sys->sharpness_ = sharpness;
 
-	filter->pf_video_filter = Filter;
-
-	var_AddCallback(obj, kVarNameSharpness, VariableChangeCallback, nullptr);
-
-	VlcLog(obj, VLC_MSG_INFO, "Open success");
-
-	return VLC_SUCCESS;
-}
-
-void Close(vlc_object_t *obj)
-{
-	filter_t *filter = reinterpret_cast<filter_t *>(obj);
-
-	filter->p_sys->device_->Release();
-	filter->p_sys->device_context_->Release();
-	filter->p_sys->dynamic_texture_->Release();
-	filter->p_sys->default_texture_->Release();
-	filter->p_sys->staging_texture_->Release();
-	filter->p_sys->cas_shader_->Release();
-	filter->p_sys->argumanet_buffer_->Release();
-	filter->p_sys->uav_->Release();
-
-	var_DelCallback(obj, kVarNameSharpness, VariableChangeCallback, nullptr);
-
-	VlcLog(obj, VLC_MSG_INFO, "Close success");
-
-	delete filter->p_sys;
-}
-
-picture_t *Filter(filter_t *filter, picture_t *input_picture)
-{
-	vlc_object_t *obj = VLC_OBJECT(filter);
-	picture_t *output_picture;
-
-
-	// ̓sN`ꍇ
-	if (!input_picture)
-	{
-		VlcLog(obj, VLC_MSG_INFO, "Null input picture.");
-		return nullptr;
-	}
-
-	// o̓sN`̊蓖Ăs
-	output_picture = filter_NewPicture(filter);
-	if (!output_picture)
-	{
-		VlcLog(obj, VLC_MSG_INFO, "Can not prepare new picture.");
-		picture_Release(input_picture);
-		return nullptr;
-	}
-
-	// ̓sN`̃tH[}bgTCYsȏꍇAo̓sN`ɓ̓sN`Rs[ĕԂ
-	if (!ValidatePicture(filter, input_picture))
-	{
-		VlcLog(obj, VLC_MSG_INFO, "Invalid picture.");
-		picture_Copy(output_picture, input_picture);
-		picture_Release(input_picture);
-		return output_picture;
-	}
-
-	// picture̓edynamic textureփRs[邱Ƃ݂
-	// sꍇAo̓sN`ɓ̓sN`Rs[Ԃ
-	if (!CopyPictureToDynamicTexture(filter, input_picture))
-	{
-		VlcLog(obj, VLC_MSG_INFO, "Failed CopyPictureToDynamicTexture");
-		picture_Copy(output_picture, input_picture);
-		picture_Release(input_picture);
-		return output_picture;
-	}
-
-	// dynamic textureǂ݁ACAS̏ʂdefault textureɏ
-	Cas(filter, input_picture);
-
-	// default texture̓estaging textureփRs[
-	CopyDefaultTextureToStagingTexture(filter);
-
-	// staging texture̓eoutput_pictureփRs[
-	// sꍇAo̓sN`ɓ̓sN`Rs[Ԃ
-	if (!CopyStagingTextureToPicture(filter, output_picture))
-	{
-		VlcLog(obj, VLC_MSG_INFO, "Failed CopyStagingTextureToPicture");
-		picture_Copy(output_picture, input_picture);
-		picture_Release(input_picture);
-		return output_picture;
-	}
-
-	picture_CopyProperties(output_picture, input_picture);
-	picture_Release(input_picture);
-
-	return output_picture;
-}
-
-int VariableChangeCallback(vlc_object_t *obj, char const *variable_name, vlc_value_t old_value, vlc_value_t new_value, void *data)
-{
-	filter_t *filter = reinterpret_cast<filter_t *>(obj);
-	filter_sys_t *sys = reinterpret_cast<filter_sys_t *>(filter->p_sys);
-
-	if (0 == strcmp(kVarNameSharpness, variable_name))
-		sys->sharpness_.store(new_value.f_float);
-
-	return VLC_SUCCESS;
-}
-
-void VlcLog(vlc_object_t *obj, vlc_log_type prio, const char *format, ...)
-{
-	va_list ap;
-
-	va_start(ap, format);
-	vlc_vaLog(obj, prio, vlc_module_name, nullptr, 0, nullptr, format, ap);
-	va_end(ap);
+	return true;
 }
 
 bool SetupCom()
@@ -556,25 +1022,56 @@ bool CreateComputeShader(ID3D11ComputeShader **shader, ID3D11Device *device, HMO
 	return true;
 }
 
+bool CreateComputeShaders(wil::com_ptr<ID3D11ComputeShader> (&shaders)[kQualityLevels], ID3D11Device *device, HMODULE module, const char *const (&resource_names)[kQualityLevels])
+{
+	for (int i=0; i<kQualityLevels; ++i)
+	{
+		if (!CreateComputeShader(&shaders[i], device, module, "SHADER", resource_names[i]))
+			return false;
+	}
+
+	return true;
+}
+#endif
+
+// CPUŏꍇ̍Ɨ̈A͂̑傫狁߂ĊmۂAeGWɓn
+bool SetupScratch(filter_t *filter)
+{
+	filter_sys_t *sys = filter->p_sys;
+	int width = static_cast<int>(filter->fmt_in.video.i_width);
+	int height = static_cast<int>(filter->fmt_in.video.i_height);
+
+	size_t engine_size = CasArenaPitch(CasCpuScratchSize(sys->cpu_engine_, 4, width, height));
+	size_t pipeline_size = sys->pipeline_ ? CasCpuPipelineScratchSize(sys->pipeline_, width, height) : 0;
+
+	if (!CasArenaCreateOnNode(&sys->arena_, engine_size + pipeline_size, true, sys->numa_node_))
+		return false;
+
+	CasCpuSetScratch(sys->cpu_engine_, CasArenaAlloc(&sys->arena_, engine_size), engine_size);
+	if (sys->pipeline_)
+		CasCpuPipelineSetScratch(sys->pipeline_, CasArenaAlloc(&sys->arena_, pipeline_size), pipeline_size);
+
+	return true;
+}
+
 bool ValidatePicture(filter_t *filter, picture_t *input_picture)
 {
 	video_format_t *format = &input_picture->format;
-	D3D11_TEXTURE2D_DESC desc;
-
-	filter->p_sys->dynamic_texture_->GetDesc(&desc);
 
+	// dynamic textureCPȔ͈͂́Aǂ̓tH[}bg̑傫
 	if (VLC_CODEC_RGB32 != format->i_chroma)
 		return false;
 
-	if (desc.Width < format->i_visible_width)
+	if (filter->fmt_in.video.i_width < format->i_visible_width)
 		return false;
 
-	if (desc.Height < format->i_visible_height)
+	if (filter->fmt_in.video.i_height < format->i_visible_height)
 		return false;
 
 	return true;
 }
 
+#if CAS_USE_D3D11
 bool CopyPictureToDynamicTexture(filter_t *filter, picture_t *input_picture)
 {
 	ID3D11DeviceContext *device_context = filter->p_sys->device_context_;
@@ -656,6 +1153,393 @@ bool CopyStagingTextureToPicture(filter_t *filter, picture_t *output_picture)
 
 	return true;
 }
+#endif
+
+
+// ̓sN`pCvCɓȀIsN`𓊓̏ p_next łȂŕԂ
+// 󂫂ꍇ͍łÂsN`҂߁Aɏt[ K ƂƁA茳Ɏĉ͏ K - 1 ܂łƂȂ
+// ̏IsN`cԂ߁AXg[I_ŗƂ̂͏̃sN`݂̂ƂȂ
+picture_t *FilterFrames(filter_t *filter, picture_t *input_picture, mtime_t start, mtime_t interval)
+{
+	filter_sys_t *sys = filter->p_sys;
+	CasCpuPipeline *pipeline = sys->pipeline_;
+	picture_t *output_picture = nullptr;
+	picture_t *result = nullptr;
+
+	// 󂫂ꍇAłÂsN`̏Î҂Ă瓊
+	if (CasCpuPipelineDepth(pipeline) <= CasCpuPipelinePending(pipeline))
+		result = ReceiveFrame(filter, true);
+
+	// CASKpȂsN`AɓsN`ǂzȂ悤ɃpCvCɕׂ
+	// o̓sN`蓖ĂȂꍇA̓sN`̂܂ܕԂ
+	if (kPassthroughQuality != sys->quality_)
+	{
+		if (!ValidatePicture(filter, input_picture))
+		{
+			CountEvent(filter, kEventInvalidPicture);
+		}
+		else
+		{
+			output_picture = filter_NewPicture(filter);
+			if (!output_picture)
+				CountEvent(filter, kEventNoOutputPicture);
+		}
+	}
+
+	CasFrame *frame = &sys->frames_[sys->next_frame_];
+	sys->next_frame_ = (sys->next_frame_ + 1) % static_cast<int>(sys->frames_.size());
+	frame->input = input_picture;
+	frame->output = output_picture;
+
+	if (output_picture)
+	{
+		plane_t *src_plane = &input_picture->p[0];
+		plane_t *dst_plane = &output_picture->p[0];
+		CasCpuImage src;
+		CasCpuImage dst;
+
+		src.pixels = src_plane->p_pixels;
+		src.pitch = src_plane->i_pitch;
+		src.width = std::min(src_plane->i_visible_pitch, dst_plane->i_visible_pitch) / src_plane->i_pixel_pitch;
+		src.height = std::min(src_plane->i_visible_lines, dst_plane->i_visible_lines);
+		dst = src;
+		dst.pixels = dst_plane->p_pixels;
+		dst.pitch = dst_plane->i_pitch;
+
+		picture_CopyProperties(output_picture, input_picture);
+		CasCpuPipelineSubmit(pipeline, &src, &dst, sys->sharpness_.load(), sys->quality_, frame);
+	}
+	else
+	{
+		CasCpuPipelineSubmit(pipeline, nullptr, nullptr, 0.0f, 0, frame);
+	}
+
+	result = ReceiveFrames(filter, result, false);
+
+	// Ԃł͍łÂsN`̏I҂Ԃ܂܂邽߁A1t[̏\͂ɌԂɂȂ
+	// CAS͘g̃Xbhő̃t[ƏdȂĐiނ߁Acompute ͐ total ̂ݐ
+	FinishFrame(filter, start, interval);
+
+	return result;
+}
+
+// łÂsN`󂯎AԂsN`߂
+// wait UŏIĂȂꍇƁÃsN`ꍇ nullptr Ԃ
+// ԂsN` p_next łȂ߁Ap_next ɂ
+picture_t *ReceiveFrame(filter_t *filter, bool wait)
+{
+	void *user_data;
+	bool filtered;
+
+	if (!CasCpuPipelineReceive(filter->p_sys->pipeline_, wait, &user_data, &filtered))
+		return nullptr;
+
+	CasFrame *frame = static_cast<CasFrame *>(user_data);
+	if (!frame->output)
+	{
+		frame->input->p_next = nullptr;
+		return frame->input;
+	}
+
+	// Ɨ̈mۂłȂꍇAo̓sN`ɓ̓sN`Rs[
+	if (!filtered)
+	{
+		CountEvent(filter, kEventScratchFailed);
+		picture_Copy(frame->output, frame->input);
+	}
+
+	picture_Release(frame->input);
+	frame->output->p_next = nullptr;
+
+	return frame->output;
+}
+
+// first ̌ɁA󂯎sN`𓊓̏ p_next łȂŕԂ
+// wait ^̏ꍇ͏̃sN`ׂđ҂AȔꍇ͏̏IĂsN`̂ݎ󂯎
+picture_t *ReceiveFrames(filter_t *filter, picture_t *first, bool wait)
+{
+	picture_t **last = &first;
+	while (*last)
+		last = &(*last)->p_next;
+
+	while (picture_t *picture = ReceiveFrame(filter, wait))
+	{
+		*last = picture;
+		last = &picture->p_next;
+	}
+
+	return first;
+}
+
+bool CasCpu(filter_t *filter, picture_t *input_picture, picture_t *output_picture)
+{
+	filter_sys_t *sys = filter->p_sys;
+	plane_t *src_plane = &input_picture->p[0];
+	plane_t *dst_plane = &output_picture->p[0];
+	CasCpuImage src;
+	CasCpuImage dst;
+
+	src.pixels = src_plane->p_pixels;
+	src.pitch = src_plane->i_pitch;
+	src.width = std::min(src_plane->i_visible_pitch, dst_plane->i_visible_pitch) / src_plane->i_pixel_pitch;
+	src.height = std::min(src_plane->i_visible_lines, dst_plane->i_visible_lines);
+	dst = src;
+	dst.pixels = dst_plane->p_pixels;
+	dst.pitch = dst_plane->i_pitch;
+
+	return CasCpuFilter(sys->cpu_engine_, &src, &dst, sys->sharpness_.load(), sys->quality_);
+}
+
+bool CasCpuInPlace(filter_t *filter, picture_t *picture)
+{
+	filter_sys_t *sys = filter->p_sys;
+	plane_t *plane = &picture->p[0];
+	CasCpuImage image;
+
+	image.pixels = plane->p_pixels;
+	image.pitch = plane->i_pitch;
+	image.width = plane->i_visible_pitch / plane->i_pixel_pitch;
+	image.height = plane->i_visible_lines;
+
+	return CasCpuFilterInPlace(sys->cpu_engine_, &image, sys->sharpness_.load(), sys->quality_);
+}
+
+// VLC 3  src/misc/picture.h  picture_priv_t Ɠ
+// SDK ͎QƐJȂ߁A̓sN`㏑Ă悢m߂邽߂ɂ̂ݓǂ
+struct CasPicturePriv
+{
+	picture_t picture;
+	struct
+	{
+		std::atomic<uintptr_t> refs;
+		void (*destroy)(picture_t *);
+		void *opaque;
+	} gc;
+};
+static_assert(sizeof (std::atomic<uintptr_t>) == sizeof (uintptr_t), "atomic_uintptr_t layout");
+
+// ̓sN`̎QƂ̃tB^1݂̂ŁA㏑Ă猩Ȃꍇ͐^
+bool PictureWritable(const picture_t *picture)
+{
+	const CasPicturePriv *priv = reinterpret_cast<const CasPicturePriv *>(picture);
+	return 1 == priv->gc.refs.load(std::memory_order_acquire);
+}
+
+void SetQuality(filter_t *filter, int quality)
+{
+	filter_sys_t *sys = filter->p_sys;
+
+#if CAS_USE_D3D11
+	if (!sys->cpu_engine_ && quality < kPassthroughQuality)
+		sys->device_context_->CSSetShader(sys->cas_shaders_[quality], nullptr, 0);
+#endif
+
+	sys->quality_ = quality;
+	sys->exported_quality_.store(quality, std::memory_order_relaxed);
+	sys->overload_frames_ = 0;
+	sys->underload_frames_ = 0;
+}
+
+mtime_t FrameInterval(filter_t *filter, picture_t *input_picture)
+{
+	filter_sys_t *sys = filter->p_sys;
+	mtime_t interval = sys->frame_interval_;
+
+	// t[[gsȏꍇAO̓̓sN`Ƃ̕\̍t[ԊuƂ
+	if (!interval && VLC_TS_INVALID != sys->last_date_ && sys->last_date_ < input_picture->date)
+		interval = input_picture->date - sys->last_date_;
+
+	sys->last_date_ = input_picture->date;
+
+	return interval;
+}
+
+void UpdateQuality(filter_t *filter, mtime_t elapsed, mtime_t interval)
+{
+	filter_sys_t *sys = filter->p_sys;
+
+	if (interval <= 0)
+		return;
+
+	sys->average_elapsed_ += (elapsed - sys->average_elapsed_) / 8;
+	double load = static_cast<double>(sys->average_elapsed_) / static_cast<double>(interval);
+
+	if (kDowngradeLoad < load)
+	{
+		++sys->overload_frames_;
+		sys->underload_frames_ = 0;
+	}
+	else if (load < kUpgradeLoad)
+	{
+		++sys->underload_frames_;
+		sys->overload_frames_ = 0;
+	}
+	else
+	{
+		sys->overload_frames_ = 0;
+		sys->underload_frames_ = 0;
+	}
+
+	int quality = sys->quality_;
+	if (kDowngradeFrames <= sys->overload_frames_ && quality < kPassthroughQuality)
+		++quality;
+	else if (kUpgradeFrames <= sys->underload_frames_ && sys->base_quality_ < quality)
+		--quality;
+
+	if (quality == sys->quality_)
+		return;
+
+	VlcLog(VLC_OBJECT(filter), VLC_MSG_DBG, "Quality level %d -> %d (load %.2f)", sys->quality_, quality, load);
+
+	SetQuality(filter, quality);
+}
+
+// Filter ̏IɌĂсAŜ̏Ԃi̒Ɠvɔf
+// O񂩂 kStatsPublishIntervalMs ȏoĂ΁Avϐɏ
+void FinishFrame(filter_t *filter, mtime_t start, mtime_t interval)
+{
+	filter_sys_t *sys = filter->p_sys;
+	mtime_t now = RecordStage(filter, kCasStageTotal, start);
+	CAS_PROBE3(frame__end, sys->frame_index_, now - start, sys->quality_);
+
+	UpdateQuality(filter, now - start, interval);
+
+	if (kStatsPublishIntervalMs * CLOCK_FREQ / 1000 <= now - sys->stats_published_)
+	{
+		sys->stats_published_ = now;
+		PublishStats(filter);
+	}
+}
+
+// start ̌oߎԂAiK stage ̏ԂƂĐA݂̎Ԃ
+// g[XL^Ăꍇ́AԂg[Xɂ
+mtime_t RecordStage(filter_t *filter, int stage, mtime_t start)
+{
+	mtime_t now = mdate();
+	uint64_t elapsed = static_cast<uint64_t>(std::max<mtime_t>(0, now - start));
+
+	CasStatsRecord(&filter->p_sys->stats_[stage], elapsed);
+	CAS_PROBE3(stage__end, filter->p_sys->frame_index_, stage, elapsed);
+
+	// g[X̎̓[J[ƓvŋL^邽߁AIoߎԂk
+	if (filter->p_sys->tracing_ && CasTraceEnabled())
+	{
+		uint64_t end = CasTraceNow();
+		CasTraceSpan(CasStageName(stage), "frame", end - elapsed, end, static_cast<int64_t>(filter->p_sys->frame_index_));
+	}
+
+	return now;
+}
+
+void StatsVariableName(char (&name)[64], int stage, int field)
+{
+	snprintf(name, sizeof (name), STATS_VAR_PREFIX "%s-%s", CasStageName(stage), kStatsFieldNames[field]);
+}
+
+void CreateStatsVariables(filter_t *filter)
+{
+	vlc_object_t *obj = VLC_OBJECT(filter);
+	char name[64];
+
+	for (int stage=0; stage<kCasStages; ++stage)
+	{
+		CasStatsReset(&filter->p_sys->stats_[stage]);
+		for (int field=0; field<kStatsFields; ++field)
+		{
+			StatsVariableName(name, stage, field);
+			var_Create(obj, name, VLC_VAR_INTEGER);
+		}
+	}
+
+	filter->p_sys->stats_published_ = mdate();
+}
+
+void DestroyStatsVariables(filter_t *filter)
+{
+	vlc_object_t *obj = VLC_OBJECT(filter);
+	char name[64];
+
+	for (int stage=0; stage<kCasStages; ++stage)
+	{
+		for (int field=0; field<kStatsFields; ++field)
+		{
+			StatsVariableName(name, stage, field);
+			var_Destroy(obj, name);
+		}
+	}
+}
+
+// vϐɏ
+// ϐ̓tB^݂̂Ap͓ǂނ݂̂Ƃ
+void PublishStats(filter_t *filter)
+{
+	vlc_object_t *obj = VLC_OBJECT(filter);
+	char name[64];
+
+	for (int stage=0; stage<kCasStages; ++stage)
+	{
+		const CasStageStats *stats = &filter->p_sys->stats_[stage];
+		uint64_t count = stats->count_.load(std::memory_order_relaxed);
+		uint64_t values[kStatsFields] =
+		{
+			count,
+			stats->sum_.load(std::memory_order_relaxed),
+			count ? stats->min_.load(std::memory_order_relaxed) : 0,
+			stats->max_.load(std::memory_order_relaxed),
+			CasStatsPercentile(stats, 0.50),
+			CasStatsPercentile(stats, 0.99),
+		};
+
+		for (int field=0; field<kStatsFields; ++field)
+		{
+			StatsVariableName(name, stage, field);
+			var_SetInteger(obj, name, static_cast<int64_t>(values[field]));
+		}
+	}
+}
+
+// ُ𐔂AO񃍃OɏĂ kEventReportIntervalMs oĂ΂܂Ƃ߂ď
+// ُ킪N̂݌ĂԂ߁Aȃt[̏ɂׂ͕
+void CountEvent(filter_t *filter, int event)
+{
+	filter->p_sys->event_counts_[event].fetch_add(1, std::memory_order_relaxed);
+	ReportEvents(filter, false);
+}
+
+// O񃍃OɏĂُ̈̉񐔂1sɂ܂Ƃ߂ď
+// force Ȕꍇ́AO񂩂 kEventReportIntervalMs oĂȂΏȂ
+void ReportEvents(filter_t *filter, bool force)
+{
+	filter_sys_t *sys = filter->p_sys;
+	mtime_t now = mdate();
+
+	if (!force && VLC_TS_INVALID != sys->events_reported_ && now - sys->events_reported_ < kEventReportIntervalMs * CLOCK_FREQ / 1000)
+		return;
+
+	char message[512];
+	int length = 0;
+	for (int event=0; event<kFilterEvents; ++event)
+	{
+		uint64_t count = sys->event_counts_[event].load(std::memory_order_relaxed);
+		uint64_t delta = count - sys->reported_counts_[event];
+		sys->reported_counts_[event] = count;
+		if (!delta || sizeof (message) <= static_cast<size_t>(length))
+			continue;
+
+		length += snprintf(message + length, sizeof (message) - length, "%s%s x%llu", length ? ", " : "", kFilterEventNames[event], static_cast<unsigned long long>(delta));
+	}
+
+	if (!length)
+		return;
+
+	// ŏ1͌oߎԂ߁A񐔂݂̂
+	if (VLC_TS_INVALID == sys->events_reported_)
+		VlcLog(VLC_OBJECT(filter), VLC_MSG_WARN, "%s", message);
+	else
+		VlcLog(VLC_OBJECT(filter), VLC_MSG_WARN, "%s in the last %.1f s", message, static_cast<double>(now - sys->events_reported_) / CLOCK_FREQ);
+
+	sys->events_reported_ = now;
+}
 
 
 vlc_module_begin()
@@ -668,6 +1552,13 @@ set_subcategory(SUBCAT_VIDEO_VFILTER)
 add_integer(kVarNameAdapter, 0, "Adapter", "Adapter-number (0 .. n-1)", false)
 add_float_with_range(kVarNameSharpness, 0.8, 0.0, 1.0, "Sharpness", "Sharpness [0, 1]", false)
 add_bool(kVarNameFp16prefer, false, "FP16", "FP16 is preferred use.", false)
+add_integer(kVarNameQuality, kCasQualityBest, "Quality", "Quality preset (Best .. Fast), faster presets sharpen less accurately.", false)
+change_integer_list(kQualityValues, kQualityTexts)
+add_bool(kVarNameInPlace, false, "In-place", "Overwrite the input picture instead of allocating an output picture (CPU only). Pictures that are still referenced elsewhere are written to a new picture instead.", false)
+add_integer_with_range(kVarNameFrames, 1, 1, kMaxFramesInFlight, "Frames in flight", "Number of frames processed in parallel (CPU only). Values above 1 raise throughput on many-core machines at the cost of that many frames minus one of latency.", false)
+add_integer(kVarNameNumaNode, -1, "NUMA node", "Pin the CPU workers and their scratch memory to this NUMA node (CPU only). -1 leaves placement to the OS.", false)
+add_string(kVarNameTraceFile, "", "Trace file", "Record per-frame stage and worker spans to this file in Chrome trace-event JSON (open it in Perfetto or chrome://tracing). Empty disables tracing.", true)
+add_string(kVarNameMetrics, "", "Metrics export", "Export the counters of every CAS filter in the process in Prometheus text format. unix:<path> serves them over a Unix domain socket, any other value is a file rewritten every 5 seconds. Empty disables the export.", true)
 
 add_shortcut("FidelityFX CAS")
 set_callbacks(Open, Close)
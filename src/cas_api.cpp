@@ -0,0 +1,116 @@
+#include <new>
+
+#include "cas_api.h"
+#include "cas_arena.h"
+#include "cas_cpu.h"
+
+
+struct cas_context
+{
+	CasCpuEngine *engine_;
+	CasArena scratch_; // cas_context_reserve ŊmۂƗ̈
+};
+
+
+// `Ƃ̃`lAsȌ`̏ꍇ0
+static int FormatChannels(cas_format format)
+{
+	switch (format)
+	{
+	case CAS_FORMAT_BGRA8:
+		return 4;
+
+	case CAS_FORMAT_PLANE8:
+		return 1;
+	}
+
+	return 0;
+}
+
+
+cas_context *cas_context_create(int thread_count)
+{
+	cas_context *context = new(std::nothrow) cas_context;
+	if (!context)
+		return nullptr;
+
+	context->engine_ = CasCpuCreate(thread_count);
+	if (!context->engine_)
+	{
+		delete context;
+		return nullptr;
+	}
+
+	CasArenaCreate(&context->scratch_, 0, false);
+
+	return context;
+}
+
+void cas_context_destroy(cas_context *context)
+{
+	if (!context)
+		return;
+
+	CasCpuDestroy(context->engine_);
+	CasArenaDestroy(&context->scratch_);
+	delete context;
+}
+
+cas_status cas_context_reserve(cas_context *context, cas_format format, int max_width, int max_height)
+{
+	int channels = FormatChannels(format);
+	if (!context || !channels || max_width <= 0 || max_height <= 0)
+		return CAS_ERROR_INVALID_ARGUMENT;
+
+	size_t size = CasCpuScratchSize(context->engine_, channels, max_width, max_height);
+	if (size <= context->scratch_.size_)
+		return CAS_OK;
+
+	// mۂłȂꍇɂ܂ł̍Ɨ̈ۂ߁AɐV̈mۂ
+	CasArena scratch;
+	if (!CasArenaCreate(&scratch, size, true))
+		return CAS_ERROR_OUT_OF_MEMORY;
+
+	CasCpuSetScratch(context->engine_, scratch.base_, scratch.size_);
+	CasArenaDestroy(&context->scratch_);
+	context->scratch_ = scratch;
+
+	return CAS_OK;
+}
+
+cas_status cas_process(cas_context *context, cas_format format, const cas_image_view *src, const cas_image *dst, float sharpness, cas_quality quality)
+{
+	if (!context || !src || !dst || !src->data || !dst->data)
+		return CAS_ERROR_INVALID_ARGUMENT;
+	if (src->width <= 0 || src->height <= 0 || src->width != dst->width || src->height != dst->height)
+		return CAS_ERROR_INVALID_ARGUMENT;
+	if (quality < CAS_QUALITY_BEST || CAS_QUALITY_FAST < quality)
+		return CAS_ERROR_INVALID_ARGUMENT;
+	if (!(0.0f <= sharpness && sharpness <= 1.0f))
+		return CAS_ERROR_INVALID_ARGUMENT;
+
+	int channels = FormatChannels(format);
+	if (!channels)
+		return CAS_ERROR_INVALID_ARGUMENT;
+
+	// GWɍƗ̈mۂȂ悤AȂꍇ͏Ȃ
+	if (context->scratch_.size_ < CasCpuScratchSize(context->engine_, channels, src->width, src->height))
+		return CAS_ERROR_NOT_RESERVED;
+
+	// ďö̗̂܂܎QƂ
+	// CasCpuImage  pixels  const ł͂ȂAsrc ɂ͏Ȃ
+	CasCpuImage s;
+	s.pixels = const_cast<uint8_t *>(src->data);
+	s.pitch = src->pitch;
+	s.width = src->width;
+	s.height = src->height;
+
+	CasCpuImage d;
+	d.pixels = dst->data;
+	d.pitch = dst->pitch;
+	d.width = dst->width;
+	d.height = dst->height;
+
+	bool filtered = 4 == channels ? CasCpuFilter(context->engine_, &s, &d, sharpness, quality) : CasCpuFilterPlane(context->engine_, &s, &d, sharpness, quality);
+	return filtered ? CAS_OK : CAS_ERROR_OUT_OF_MEMORY;
+}
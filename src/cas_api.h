@@ -0,0 +1,94 @@
+#ifndef CAS_API_H
+#define CAS_API_H
+
+// VLCɈˑCASgݍނ߂CAPI
+// 摜͌ďoLAcas_process ͗̈̊mۂRs[sȂ
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(CAS_API_SHARED)
+#ifdef CAS_API_EXPORTS
+#define CAS_API __declspec(dllexport)
+#else
+#define CAS_API __declspec(dllimport)
+#endif
+#elif defined(CAS_API_EXPORTS) && defined(__GNUC__)
+#define CAS_API __attribute__((visibility("default")))
+#else
+#define CAS_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// f̌`
+typedef enum cas_format
+{
+	CAS_FORMAT_BGRA8 = 0, // 8bit BGRAAAt@0xffŏo͂
+	CAS_FORMAT_PLANE8 = 1, // 8bit 1`l (YUV̋Px̕ʂȂ)
+} cas_format;
+
+// iAcas_cpu.h  CasQuality Ɠ
+typedef enum cas_quality
+{
+	CAS_QUALITY_BEST = 0,
+	CAS_QUALITY_HIGH = 1,
+	CAS_QUALITY_MEDIUM = 2,
+	CAS_QUALITY_FAST = 3,
+} cas_quality;
+
+typedef enum cas_status
+{
+	CAS_OK = 0,
+	CAS_ERROR_INVALID_ARGUMENT = -1,
+	CAS_ERROR_OUT_OF_MEMORY = -2, // Ɨ̈mۂłAdst ɂ͏ĂȂ
+	CAS_ERROR_NOT_RESERVED = -3, // cas_context_reserve ŊmۂƗ̈ł͑肸Adst ɂ͏ĂȂ
+} cas_status;
+
+// ͂̉摜
+// pitch 1s̃oCgŁȀꍇ͉ւ̕тɂȂ
+typedef struct cas_image_view
+{
+	const uint8_t *data;
+	ptrdiff_t pitch;
+	int width;
+	int height;
+} cas_image_view;
+
+// o͂̉摜A͂ƏdȂȂ
+typedef struct cas_image
+{
+	uint8_t *data;
+	ptrdiff_t pitch;
+	int width;
+	int height;
+} cas_image;
+
+typedef struct cas_context cas_context;
+
+
+// thread_count 0̏ꍇA_vZbT̃Xbhŏ
+// sꍇ NULL Ԃ
+CAS_API cas_context *cas_context_create(int thread_count);
+CAS_API void cas_context_destroy(cas_context *context);
+
+// format ̉摜ő max_width x max_height ܂ŏłƗ̈mۂ
+// ̌`ꍇ͌`ƂɌĂԁAƗ͍̈ł傫̂ɍ킹AĂꍇ͊mۂȂ
+// mۂłȂꍇ CAS_ERROR_OUT_OF_MEMORY ԂA܂ł̍Ɨ̈ۂ
+// cas_process ƓɌĂł͂ȂȂ
+CAS_API cas_status cas_context_reserve(cas_context *context, cas_format format, int max_width, int max_height);
+
+// src CASKpAdst ɏ
+// src  dst ̑傫͓ł邱
+//  context ɑ΂ĕ̃Xbh瓯ɌĂł͂ȂȂ
+// cas_context_reserve ŊmۂƗ݂̈̂pAɂ̓q[vmۂȂ
+// Ɨ̈悪Ȃꍇ CAS_ERROR_NOT_RESERVED Ԃ
+CAS_API cas_status cas_process(cas_context *context, cas_format format, const cas_image_view *src, const cas_image *dst, float sharpness, cas_quality quality);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
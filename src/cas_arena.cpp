@@ -0,0 +1,242 @@
+#include <stdlib.h>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#include <malloc.h>
+#else
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+#include "cas_arena.h"
+#include "cas_numa.h"
+
+
+// 4KiBGCAVONAǂݏ̃AhX̍̎
+static const size_t kAliasingPeriod = 4096;
+
+
+static size_t RoundUp(size_t size, size_t unit)
+{
+	return (size + unit - 1) & ~(unit - 1);
+}
+
+#ifdef _WIN32
+// [Wy[W̊mۂɂ́AvZX̃g[N SeLockMemoryPrivilege LɂKv
+// [U[ɂ̌蓖ĂĂȂꍇ͎s
+static bool EnableLockMemoryPrivilege()
+{
+	HANDLE token;
+	if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+		return false;
+
+	TOKEN_PRIVILEGES privileges{};
+	privileges.PrivilegeCount = 1;
+	privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+	bool enabled = LookupPrivilegeValueW(nullptr, SE_LOCK_MEMORY_NAME, &privileges.Privileges[0].Luid)
+		&& AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr)
+		&& ERROR_SUCCESS == GetLastError();
+
+	CloseHandle(token);
+
+	return enabled;
+}
+
+// q[voRɊmۂ
+// node łȂꍇ́Ãm[h̃Ŋmۂ
+static bool CreateMapped(CasArena *arena, size_t size, bool huge_pages, int node)
+{
+	DWORD preferred = 0 <= node ? static_cast<DWORD>(node) : NUMA_NO_PREFERRED_NODE;
+
+	SIZE_T large_page_size = GetLargePageMinimum();
+	if (huge_pages && large_page_size && EnableLockMemoryPrivilege())
+	{
+		size_t mapped_size = RoundUp(size, large_page_size);
+		void *base = VirtualAllocExNuma(GetCurrentProcess(), nullptr, mapped_size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE, preferred);
+		if (base)
+		{
+			arena->base_ = static_cast<uint8_t *>(base);
+			arena->mapped_size_ = mapped_size;
+			arena->pages_ = kCasArenaHugePages;
+			return true;
+		}
+	}
+
+	// Windows ɂ͓ߓIȃq[Wy[W߁Am[h̎w肪΃q[vmۂ
+	if (node < 0)
+		return false;
+
+	void *base = VirtualAllocExNuma(GetCurrentProcess(), nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, preferred);
+	if (!base)
+		return false;
+
+	arena->base_ = static_cast<uint8_t *>(base);
+	arena->mapped_size_ = size;
+
+	return true;
+}
+#elif defined(MAP_ANONYMOUS)
+// q[Wy[WŊmۂ
+static bool MapHugePages(CasArena *arena, size_t size)
+{
+	size_t mapped_size = RoundUp(size, kCasHugePageSize);
+
+#ifdef MAP_HUGETLB
+	// hugetlbfs ̃y[W͎Oɗ\񂵂߁As邱Ƃ
+	void *base = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (MAP_FAILED != base)
+	{
+		arena->base_ = static_cast<uint8_t *>(base);
+		arena->mapped_size_ = mapped_size;
+		arena->pages_ = kCasArenaHugePages;
+		return true;
+	}
+#endif
+
+#ifdef MADV_HUGEPAGE
+	// ߓIȃq[Wy[W2MiBEɑ͈͂ɂ̂݊蓖Ă邽߁A]ɊmۂđOԂ
+	size_t reserve_size = mapped_size + kCasHugePageSize;
+	void *reserve = mmap(nullptr, reserve_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (MAP_FAILED == reserve)
+		return false;
+
+	uint8_t *begin = static_cast<uint8_t *>(reserve);
+	uint8_t *aligned = reinterpret_cast<uint8_t *>(RoundUp(reinterpret_cast<uintptr_t>(begin), kCasHugePageSize));
+	size_t head = aligned - begin;
+	size_t tail = reserve_size - head - mapped_size;
+	if (head)
+		munmap(begin, head);
+	if (tail)
+		munmap(aligned + mapped_size, tail);
+
+	arena->base_ = aligned;
+	arena->mapped_size_ = mapped_size;
+	arena->pages_ = 0 == madvise(aligned, mapped_size, MADV_HUGEPAGE) ? kCasArenaTransparentHugePages : kCasArenaSmallPages;
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+// q[voRɊmۂ
+// node łȂꍇ́Ay[WɏOɂ̃m[h̃蓖Ă悤w肷
+static bool CreateMapped(CasArena *arena, size_t size, bool huge_pages, int node)
+{
+	if (!huge_pages || size < kCasHugePageSize || !MapHugePages(arena, size))
+	{
+		if (node < 0)
+			return false;
+
+		size_t mapped_size = RoundUp(size, static_cast<size_t>(sysconf(_SC_PAGESIZE)));
+		void *base = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (MAP_FAILED == base)
+			return false;
+
+		arena->base_ = static_cast<uint8_t *>(base);
+		arena->mapped_size_ = mapped_size;
+	}
+
+	if (0 <= node)
+		CasNumaBindMemory(arena->base_, arena->mapped_size_, node);
+
+	return true;
+}
+#else
+static bool CreateMapped(CasArena *arena, size_t size, bool huge_pages, int node)
+{
+	return false;
+}
+#endif
+
+bool CasArenaCreate(CasArena *arena, size_t size, bool huge_pages)
+{
+	return CasArenaCreateOnNode(arena, size, huge_pages, -1);
+}
+
+bool CasArenaCreateOnNode(CasArena *arena, size_t size, bool huge_pages, int node)
+{
+	arena->base_ = nullptr;
+	arena->size_ = 0;
+	arena->used_ = 0;
+	arena->pages_ = kCasArenaSmallPages;
+	arena->mapped_size_ = 0;
+
+	size = RoundUp(size, kCasArenaAlignment);
+	if (!size)
+		return true;
+
+	if (((huge_pages && kCasHugePageSize <= size) || 0 <= node) && CreateMapped(arena, size, huge_pages, node))
+	{
+		arena->size_ = size;
+		return true;
+	}
+
+#ifdef _WIN32
+	void *base = _aligned_malloc(size, kCasArenaAlignment);
+	if (!base)
+		return false;
+#else
+	void *base = nullptr;
+	if (0 != posix_memalign(&base, kCasArenaAlignment, size))
+		return false;
+#endif
+
+	arena->base_ = static_cast<uint8_t *>(base);
+	arena->size_ = size;
+
+	return true;
+}
+
+void CasArenaDestroy(CasArena *arena)
+{
+	if (arena->mapped_size_)
+	{
+#ifdef _WIN32
+		VirtualFree(arena->base_, 0, MEM_RELEASE);
+#elif defined(MAP_ANONYMOUS)
+		munmap(arena->base_, arena->mapped_size_);
+#endif
+	}
+	else
+	{
+#ifdef _WIN32
+		_aligned_free(arena->base_);
+#else
+		free(arena->base_);
+#endif
+	}
+
+	arena->base_ = nullptr;
+	arena->size_ = 0;
+	arena->used_ = 0;
+	arena->pages_ = kCasArenaSmallPages;
+	arena->mapped_size_ = 0;
+}
+
+void *CasArenaAlloc(CasArena *arena, size_t size)
+{
+	size = RoundUp(size, kCasArenaAlignment);
+	if (arena->size_ - arena->used_ < size)
+		return nullptr;
+
+	void *p = arena->base_ + arena->used_;
+	arena->used_ += size;
+
+	return p;
+}
+
+void CasArenaReset(CasArena *arena)
+{
+	arena->used_ = 0;
+}
+
+size_t CasArenaPitch(size_t row_bytes)
+{
+	size_t pitch = RoundUp(row_bytes, kCasArenaAlignment);
+	if (0 == pitch % kAliasingPeriod)
+		pitch += kCasArenaAlignment;
+
+	return pitch;
+}
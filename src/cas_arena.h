@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+// ̈蓖Ăy[W̎
+enum CasArenaPages
+{
+	kCasArenaSmallPages = 0, // ʏ̃y[W
+	kCasArenaTransparentHugePages, // madvise œߓIȃq[Wy[Wv (J[l蓖ĂƂ͌Ȃ)
+	kCasArenaHugePages, // hugetlbfsAWindows ł̓[Wy[W
+};
+
+// 64oCgEɑ̈xɊmۂA擪珇ɐ؂oēn
+// ؂ö͌ʂɂ͉ACasArenaDestroy ł܂Ƃ߂ĉ
+// Filter Ȃǂ̏̓rŃq[vmۂȂ悤AKvȗ̈͏̊JnOɐ؂oĂ
+struct CasArena
+{
+	uint8_t *base_;
+	size_t size_;
+	size_t used_;
+	CasArenaPages pages_;
+	size_t mapped_size_; // mmap ȂǂŒڊmۂꍇ̑傫Aq[vmۂꍇ0
+};
+
+// ؂ö̋E
+static const size_t kCasArenaAlignment = 64;
+
+// q[Wy[W̑傫
+static const size_t kCasHugePageSize = 2 * 1024 * 1024;
+
+// size oCg̗̈mۂAsꍇ false Ԃ arena ͋ɂȂ
+// huge_pages ^ size q[Wy[Wȏ̏ꍇAq[Wy[Wł̊mۂ݂
+// 傫ȃt[cɒH鏈ł́Aʏ̃y[Wł͍sƂTLBO߁Aq[Wy[WŊO񐔂炷
+// hugetlbfs ̃y[WmۂłȂꍇ́AߓIȃq[Wy[WvAłȂꍇ͒ʏ̃y[WŊmۂ
+bool CasArenaCreate(CasArena *arena, size_t size, bool huge_pages);
+
+// CasArenaCreate ƓmۂAnode łȂꍇ͂NUMAm[h̃蓖Ă
+// 摜郏[J[Ɠm[hɒuAʂ̃m[h̃ǂ܂Ȃ悤ɂ
+bool CasArenaCreateOnNode(CasArena *arena, size_t size, bool huge_pages, int node);
+void CasArenaDestroy(CasArena *arena);
+
+// size 64oCgPʂɐ؂グ̈؂oAc肪Ȃꍇ nullptr Ԃ
+void *CasArenaAlloc(CasArena *arena, size_t size);
+
+// ؂öׂĕԂA擪؂o
+void CasArenaReset(CasArena *arena);
+
+// 1s row_bytes ̉摜Ɨ̈́A64oCgPʂɑ1s̃oCg
+// 4KiB̔{ɂȂꍇ1LbVCA㉺̍s̓4KiBGCAVOŏՓ˂Ȃ悤ɂ
+size_t CasArenaPitch(size_t row_bytes);
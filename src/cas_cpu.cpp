@@ -0,0 +1,1121 @@
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#define A_CPU 1
+#include "ffx_a.h"
+#include "ffx_cas.h"
+
+#include "cas_arena.h"
+#include "cas_cpu.h"
+#include "cas_numa.h"
+#include "cas_probe.h"
+#include "cas_trace.h"
+
+
+// 1̎擾Ń[J[s
+static const int kBandRows = 16;
+
+// LbV̑傫擾łȂꍇɉ肷L1f[^LbV̑傫
+static const size_t kDefaultL1DataCacheSize = 32 * 1024;
+
+// c̒Z̍ŏ̕ (oCg)
+// 苷ƁAZ̒[̏dȂƍs̐ؑւׂ̕ڗ
+static const size_t kMinStripBytes = 1024;
+
+// d݂̕\̍
+// amp ̕_̃rbg̏ʂYƂA2{Ƃ 2^kWeightMantissaBits 
+// ̌X傫0t߂قǍׂނ߁AmȕƋtpꍇƂ̍ sRGB ōő1ɂȂ
+// 2^-kWeightOctaves  amp 0ƂĈ
+static const int kWeightMantissaBits = 8;
+static const int kWeightOctaves = 14;
+static const int kWeightSteps = kWeightOctaves << kWeightMantissaBits;
+
+// `lsRGBlւ̕ϊ\̑傫
+static const int kLinearToSrgbSize = 65536;
+
+// sRGBlƐ`l̑ݕϊɗpϊe[u
+static AF1 g_srgb_to_linear[256];
+static AB1 g_linear_to_srgb[kLinearToSrgbSize];
+static std::once_flag g_tables_once;
+
+// amp ɑ΂d݂ƁAꂩ狁߂t
+struct CasWeight
+{
+	AF1 w;
+	AF1 rcp_weight;
+};
+
+// peak Ƃ̏d݂̕\ (CasWeight ̔z)
+// amp  w = sqrt(amp) * peak  rcp(1 + 4 * w) ߂鏈́Apeak ł amp ݂̂Ō܂
+// sharpness ςꍇ̂ݍ蒼AfƂ̕ƋťvZ\̎QƂɒu
+struct CasWeightTable
+{
+	bool valid;
+	bool go_slower; // ^̏ꍇ͐mȕƋtAȔꍇ͋ߎlō
+	AF1 peak;
+	CasWeight weights[kWeightSteps + 2];
+};
+
+// ring ͏XbhƂ̍Ɨ̈ŁA`lɕϊ3su
+typedef void (*CasRowsFunction)(const CasCpuImage &src, const CasCpuImage &dst, const CasWeight *weights, int y_begin, int y_end, size_t strip_bytes, AF1 *ring);
+
+// ̏ŏꍇ̍Ɨ̈
+// тƂɁAт̒Oƒ̌̍s
+struct CasLineBuffer
+{
+	uint8_t *above; // т̒Ǒ̍s
+	uint8_t *below; // т̒̌̍s
+	AF1 *column; // т̍sƂ́AOɏZ̉E[̉f̌̐`l
+};
+
+typedef void (*CasInPlaceRowsFunction)(const CasCpuImage &image, const CasLineBuffer &lines, const CasWeight *weights, int y_begin, int y_end, size_t strip_bytes, AF1 *ring);
+
+// 1̉摜̏e
+struct CasCpuTask
+{
+	CasCpuImage src;
+	CasCpuImage dst;
+	const CasWeight *weights;
+	int band_end; // ̉摜܂ł̑т̗̐݌v
+};
+
+// 1̌ďoŏ摜̏W܂
+// S摜̑тɒʂԍtA[J[͂Ɏ擾
+struct CasCpuJob
+{
+	CasRowsFunction rows;
+	CasInPlaceRowsFunction in_place_rows; // ̏ŏꍇ̂
+	const CasCpuTask *tasks;
+	int task_count;
+	int band_count;
+	int band_rows;
+	size_t strip_bytes; // c̒Zɕďꍇ́AZ1s̃oCgA0̏ꍇ͕Ȃ
+	uint8_t *lines; // ̏ŏꍇ́AтƂ̍Ɨ̈
+	size_t line_size; // Ɨ̈1s̃oCg
+	size_t lines_size; // Ɨ̈1̑т̃oCg
+	AF1 *rings; // XbhƂ̐`l̍Ɨ̈
+	size_t ring_size; // XbhƂ̍Ɨ̗̈vf
+};
+
+struct CasCpuEngine
+{
+	std::vector<std::thread> workers_;
+	std::mutex mutex_;
+	std::condition_variable start_; // WůJn[J[ɒʒm
+	std::condition_variable done_; // S[J[̏Iďoɒʒm
+	uint64_t generation_; // WuJn邲Ƃɑ₷
+	int running_; // Wũ[J[
+	bool quit_;
+	const CasCpuJob *job_;
+	std::atomic<int> next_band_;
+	size_t strip_bytes_;
+	bool tracing_; // тƂ̋ԂL^
+	CasWeightTable weight_table_; // 1ꍇɗpd݂̕\ (蒼Ďg)
+	std::vector<CasCpuTask> tasks_; // ꊇŎg
+	std::vector<std::unique_ptr<CasWeightTable>> batch_weight_tables_; // ꊇŎg񂷁ÄقȂ摜Ƃ1
+	uint8_t *scratch_; // ďo CasCpuSetScratch œnƗ̈
+	size_t scratch_size_;
+	CasArena own_scratch_; // ďo̍Ɨ̈悪ȂꍇɊmۂƗ̈A傫Ȃꍇ̂݊mۂ
+	uint64_t scratch_allocations_; // own_scratch_ mۂ
+	int node_; // [J[ own_scratch_ uNUMAm[hȀꍇ͎w肵Ȃ
+};
+
+
+static void InitTables()
+{
+	for (int i=0; i<256; ++i)
+	{
+		double c = i / 255.0;
+		g_srgb_to_linear[i] = static_cast<AF1>(c <= 0.04045 ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4));
+	}
+
+	for (int i=0; i<kLinearToSrgbSize; ++i)
+	{
+		double c = static_cast<double>(i) / (kLinearToSrgbSize - 1);
+		double s = c <= 0.0031308 ? c * 12.92 : 1.055 * pow(c, 1.0 / 2.4) - 0.055;
+		g_linear_to_srgb[i] = static_cast<AB1>(std::min(255.0, s * 255.0 + 0.5));
+	}
+}
+
+// ffx_a.h GPŮ֐̂ACPUɗpӂĂȂ
+static inline AF1 AF1FromBits(AU1 a)
+{
+	AF1 f;
+	memcpy(&f, &a, sizeof (f));
+	return f;
+}
+
+static inline AF1 CasMin3(AF1 x, AF1 y, AF1 z)
+{
+	return AMinF1(x, AMinF1(y, z));
+}
+
+static inline AF1 CasMax3(AF1 x, AF1 y, AF1 z)
+{
+	return AMaxF1(x, AMaxF1(y, z));
+}
+
+// NaN 0ƂĈ (HLSLsaturateƓ)
+static inline AF1 CasSat(AF1 a)
+{
+	return AMinF1(AMaxF1(a, AF1_(0.0)), AF1_(1.0));
+}
+
+static inline AF1 CasPrxLoSqrt(AF1 a)
+{
+	return AF1FromBits((AU1_AF1(a) >> AU1_(1)) + AU1_(0x1fbc4639));
+}
+
+static inline AF1 CasPrxLoRcp(AF1 a)
+{
+	return AF1FromBits(AU1_(0x7ef07ebb) - AU1_AF1(a));
+}
+
+static inline AF1 CasPrxMedRcp(AF1 a)
+{
+	AF1 b = AF1FromBits(AU1_(0x7ef19fff) - AU1_AF1(a));
+	return b * (-b * a + AF1_(2.0));
+}
+
+// Y0 amp 0AŌ̓Y amp 1
+static inline int WeightIndex(AF1 amp)
+{
+	int index = static_cast<int>(AU1_AF1(amp) >> (23 - kWeightMantissaBits)) - ((127 - kWeightOctaves) << kWeightMantissaBits) + 1;
+	return std::max(index, 0);
+}
+
+static inline AF1 WeightAmp(int index)
+{
+	if (0 == index)
+		return AF1_(0.0);
+	if (kWeightSteps + 1 == index)
+		return AF1_(1.0);
+	AU1 bits = static_cast<AU1>(index - 1 + ((127 - kWeightOctaves) << kWeightMantissaBits)) << (23 - kWeightMantissaBits);
+	bits += AU1_(1) << (22 - kWeightMantissaBits); // ݂̒
+	return AF1FromBits(bits);
+}
+
+static inline AB1 ToSrgb(AF1 c)
+{
+	return g_linear_to_srgb[static_cast<int>(c * (kLinearToSrgbSize - 1) + AF1_(0.5))];
+}
+
+// 1ɏf
+// r̒l͂̉f̔zɒuAX^bNɎ܂傫ɂ
+static const int kChunkPixels = 256;
+
+// s row  x_begin - 1  x_end ܂ł̉f`lɕϊA`lƂ̔z planes ɏ
+// 摜̒[́A[̉fJԂ̂ƂĈ
+template <int kChannels>
+static void DecodeRow(const uint8_t *row, int x_begin, int x_end, int width, AF1 *const *planes)
+{
+	const int kColors = 4 == kChannels ? 3 : 1;
+	int count = x_end - x_begin + 2;
+
+	for (int i=0; i<count; ++i)
+	{
+		int x = std::clamp(x_begin - 1 + i, 0, width - 1);
+		for (int ch=0; ch<kColors; ++ch)
+			planes[ch][i] = g_srgb_to_linear[row[kChannels * x + ch]];
+	}
+}
+
+// ffx_cas.h  CasFilter (noScaling ^̏ꍇ) Ɠs
+// f̌`ƃtOƂɎ̉邽߁AfƂ͎̕cȂ
+// kChannels 4̏ꍇBGRAA1̏ꍇ͋PxȂǂ1`l̉摜ƂĈ
+// topAmiddleAbottom ̓`lƂ DecodeRow ŕϊAA̍sŁAcount f̌ʂ out ɏ
+//
+// `l̓`lƂ̔z (SoA) ŎABGRA̕т̓ւƃAt@̖̕ʂ𖳂
+// \ƂȊOʂ̃[vɕAȊÕ[v̓RpCŃxNgł`ɂ
+//
+// CAS_BETTER_DIAGONALS ̏ꍇAŏlƍől͕ċ߂
+// 񂲂Ƃ̏c̍ŏlƍől1񂾂߁A\̍ŏl͍Ẻfƒ̗̍ŏlA3x3 ̍ŏl3̍ŏl狁߂
+// ŏlƍől͔ȑɂ炸lɂȂ邽߁Aʂ͉fƂɋ߂ꍇƈv
+template <int kChannels, bool kSlow, bool kGoSlower, bool kBetterDiagonals>
+static void CasPlanarRow(const AF1 *const *top, const AF1 *const *middle, const AF1 *const *bottom, uint8_t *out, int count, const CasWeight *weights)
+{
+	const AF1 limit = kBetterDiagonals ? AF1_(2.0) : AF1_(1.0);
+	const int kColors = 4 == kChannels ? 3 : 1;
+	const int kGreen = 4 == kChannels ? 1 : 0;
+	// CAS_SLOW łȂꍇAd݂͗΂݂̂狁߂
+	const int kWeightColors = kSlow ? kColors : 1;
+	AF1 column_min[kChunkPixels + 2];
+	AF1 column_max[kChunkPixels + 2];
+	AF1 amp[kWeightColors][kChunkPixels];
+	AF1 weight[kWeightColors][kChunkPixels];
+	AF1 rcp_weight[kWeightColors][kChunkPixels];
+	AF1 value[kColors][kChunkPixels];
+
+	for (int start=0; start<count; start+=kChunkPixels)
+	{
+		int n = std::min(kChunkPixels, count - start);
+
+		// a b c
+		// d e f
+		// g h i
+		// z i + 1 ԖڂAi Ԗڂ̏o͂̉f̗
+		for (int wc=0; wc<kWeightColors; ++wc)
+		{
+			int ch = kSlow ? wc : kGreen;
+			const AF1 *t = top[ch] + start;
+			const AF1 *m = middle[ch] + start;
+			const AF1 *b = bottom[ch] + start;
+			AF1 *a = amp[wc];
+
+			if (kBetterDiagonals)
+			{
+				for (int i=0; i<n+2; ++i)
+				{
+					column_min[i] = CasMin3(t[i], m[i], b[i]);
+					column_max[i] = CasMax3(t[i], m[i], b[i]);
+				}
+
+				for (int i=0; i<n; ++i)
+				{
+					AF1 mn = CasMin3(m[i], column_min[i + 1], m[i + 2]) + CasMin3(column_min[i], column_min[i + 1], column_min[i + 2]);
+					AF1 mx = CasMax3(m[i], column_max[i + 1], m[i + 2]) + CasMax3(column_max[i], column_max[i + 1], column_max[i + 2]);
+					AF1 rcp_m = kGoSlower ? ARcpF1(mx) : CasPrxLoRcp(mx);
+					a[i] = CasSat(AMinF1(mn, limit - mx) * rcp_m);
+				}
+			}
+			else
+			{
+				for (int i=0; i<n; ++i)
+				{
+					AF1 mn = CasMin3(CasMin3(m[i], m[i + 1], m[i + 2]), t[i + 1], b[i + 1]);
+					AF1 mx = CasMax3(CasMax3(m[i], m[i + 1], m[i + 2]), t[i + 1], b[i + 1]);
+					AF1 rcp_m = kGoSlower ? ARcpF1(mx) : CasPrxLoRcp(mx);
+					a[i] = CasSat(AMinF1(mn, limit - mx) * rcp_m);
+				}
+			}
+		}
+
+		for (int wc=0; wc<kWeightColors; ++wc)
+		{
+			for (int i=0; i<n; ++i)
+			{
+				const CasWeight &cw = weights[WeightIndex(amp[wc][i])];
+				weight[wc][i] = cw.w;
+				rcp_weight[wc][i] = cw.rcp_weight;
+			}
+		}
+
+		for (int ch=0; ch<kColors; ++ch)
+		{
+			int wc = kSlow ? ch : 0;
+			const AF1 *t = top[ch] + start;
+			const AF1 *m = middle[ch] + start;
+			const AF1 *b = bottom[ch] + start;
+			const AF1 *w = weight[wc];
+			const AF1 *r = rcp_weight[wc];
+			AF1 *v = value[ch];
+
+			for (int i=0; i<n; ++i)
+			{
+				AF1 sum = t[i + 1] + m[i] + m[i + 2] + b[i + 1];
+				v[i] = CasSat((sum * w[i] + m[i + 1]) * r[i]);
+			}
+		}
+
+		// `l̕тBGRAȂ̂ŁA΂1Ԗ
+		uint8_t *o = out + kChannels * start;
+		for (int i=0; i<n; ++i)
+		{
+			for (int ch=0; ch<kColors; ++ch)
+				o[kChannels * i + ch] = ToSrgb(value[ch][i]);
+			if (4 == kChannels)
+				o[kChannels * i + 3] = 0xff;
+		}
+	}
+}
+
+// `lɕϊ3s̏zobt@
+// ring  RingSize ŋ߂傫̍Ɨ̈
+template <int kChannels>
+class CasRing
+{
+public:
+	static const int kColors = 4 == kChannels ? 3 : 1;
+
+	CasRing(AF1 *ring, int stride)
+	{
+		for (int row=0; row<3; ++row)
+		{
+			for (int ch=0; ch<kColors; ++ch)
+				planes_[row][ch] = ring + stride * (kColors * row + ch);
+		}
+	}
+
+	// y sڂi[z
+	AF1 *const *Planes(int y) const
+	{
+		return planes_[(y + 3) % 3];
+	}
+
+private:
+	AF1 *planes_[3][kColors];
+};
+
+// Z̕ (f)
+// Z1s`lɕϊƗ̈悪 strip_bytes Ɏ܂镝ƂAstrip_bytes 0̏ꍇ͕Ȃ
+static int StripWidth(size_t strip_bytes, int colors, int width)
+{
+	if (!strip_bytes)
+		return width;
+
+	return std::clamp(static_cast<int>(strip_bytes / (colors * sizeof (AF1))), 1, width);
+}
+
+// zobt@̃`lƂ̔z̑傫 (vf)
+// XbhƂ̍Ɨ̈悪LbVCLȂ悤A64oCgPʂɑ
+static size_t RingStride(int strip_width)
+{
+	return CasArenaPitch((static_cast<size_t>(strip_width) + 2) * sizeof (AF1)) / sizeof (AF1);
+}
+
+// zobt@Ŝ̑傫 (vf)
+static size_t RingSize(int colors, int strip_width)
+{
+	return RingStride(strip_width) * 3 * colors;
+}
+
+// ̍L摜ł́A1s㒆3sL1Ɏ܂Ȃ߁Ac̒Zɕď
+// Z̒ł͏ォ珇ɏAes1񂾂`lɕϊāA㒆3s̏Ŏg
+// Z̒[łׂ͗̒Z1fǂނÂ͒Z̒̂
+template <int kChannels, bool kSlow, bool kGoSlower, bool kBetterDiagonals>
+static void CasRows(const CasCpuImage &src, const CasCpuImage &dst, const CasWeight *weights, int y_begin, int y_end, size_t strip_bytes, AF1 *ring_buffer)
+{
+	const int kColors = CasRing<kChannels>::kColors;
+	int strip_width = StripWidth(strip_bytes, kColors, src.width);
+	CasRing<kChannels> ring(ring_buffer, static_cast<int>(RingStride(strip_width)));
+
+	for (int x_begin=0; x_begin<src.width; x_begin+=strip_width)
+	{
+		int x_end = std::min(x_begin + strip_width, src.width);
+
+		DecodeRow<kChannels>(src.pixels + src.pitch * std::max(y_begin - 1, 0), x_begin, x_end, src.width, ring.Planes(y_begin - 1));
+		DecodeRow<kChannels>(src.pixels + src.pitch * y_begin, x_begin, x_end, src.width, ring.Planes(y_begin));
+
+		for (int y=y_begin; y<y_end; ++y)
+		{
+			DecodeRow<kChannels>(src.pixels + src.pitch * std::min(y + 1, src.height - 1), x_begin, x_end, src.width, ring.Planes(y + 1));
+			CasPlanarRow<kChannels, kSlow, kGoSlower, kBetterDiagonals>(ring.Planes(y - 1), ring.Planes(y), ring.Planes(y + 1), dst.pixels + dst.pitch * y + kChannels * x_begin, x_end - x_begin, weights);
+		}
+	}
+}
+
+// ̏ŏт y sڂ́AZ x_begin  x_end ܂łϊ
+// ׂ̒Z͂̍s㏑Ă邽߁A[1f lines.column Ɏc̒lp
+// Eׂ̒Ẑ߁AϊE[̉f lines.column Ɏc
+template <int kChannels>
+static void DecodeBandRow(const CasCpuImage &image, const CasLineBuffer &lines, int y, int y_begin, int x_begin, int x_end, AF1 *const *planes)
+{
+	const int kColors = 4 == kChannels ? 3 : 1;
+	AF1 *column = lines.column + kColors * (y - y_begin);
+
+	DecodeRow<kChannels>(image.pixels + image.pitch * y, x_begin, x_end, image.width, planes);
+	for (int ch=0; ch<kColors; ++ch)
+	{
+		if (0 < x_begin)
+			planes[ch][0] = column[ch];
+		if (x_end < image.width)
+			column[ch] = planes[ch][x_end - x_begin];
+	}
+}
+
+// ϊsʂA[Ɖ[Ŏgׂ̍sƂꍇɗp
+template <int kChannels>
+static void CopyPlanes(AF1 *const *from, AF1 *const *to, int count)
+{
+	const int kColors = 4 == kChannels ? 3 : 1;
+	for (int ch=0; ch<kColors; ++ch)
+		memcpy(to[ch], from[ch], sizeof (AF1) * count);
+}
+
+// image ̍sォ珇ɏ㏑
+// CasRows Ɠc̒ZɕAzobt@͒Ẑ݂̕Ƃ
+// es͏㏑Oɐ`lɕϊďzobt@ɒu߁A̍sʂɕێKv͂Ȃ
+// т̒Oƒ̍s͑̑т㏑邽߁ÅJnO lines Ɏʂ̂ǂ
+// Zׂ̍1͊ɏ㏑Ă邽߁ADecodeBandRow  lines.column Ɏc̒lǂ
+template <int kChannels, bool kSlow, bool kGoSlower, bool kBetterDiagonals>
+static void CasRowsInPlace(const CasCpuImage &image, const CasLineBuffer &lines, const CasWeight *weights, int y_begin, int y_end, size_t strip_bytes, AF1 *ring_buffer)
+{
+	const int kColors = CasRing<kChannels>::kColors;
+	int width = image.width;
+	int strip_width = StripWidth(strip_bytes, kColors, width);
+	CasRing<kChannels> ring(ring_buffer, static_cast<int>(RingStride(strip_width)));
+
+	for (int x_begin=0; x_begin<width; x_begin+=strip_width)
+	{
+		int x_end = std::min(x_begin + strip_width, width);
+		int count = x_end - x_begin + 2;
+
+		DecodeBandRow<kChannels>(image, lines, y_begin, y_begin, x_begin, x_end, ring.Planes(y_begin));
+		if (0 < y_begin)
+			DecodeRow<kChannels>(lines.above, x_begin, x_end, width, ring.Planes(y_begin - 1));
+		else
+			CopyPlanes<kChannels>(ring.Planes(y_begin), ring.Planes(y_begin - 1), count);
+
+		for (int y=y_begin; y<y_end; ++y)
+		{
+			if (image.height - 1 == y)
+				CopyPlanes<kChannels>(ring.Planes(y), ring.Planes(y + 1), count);
+			else if (y_end - 1 == y)
+				DecodeRow<kChannels>(lines.below, x_begin, x_end, width, ring.Planes(y + 1));
+			else
+				DecodeBandRow<kChannels>(image, lines, y + 1, y_begin, x_begin, x_end, ring.Planes(y + 1));
+
+			CasPlanarRow<kChannels, kSlow, kGoSlower, kBetterDiagonals>(ring.Planes(y - 1), ring.Planes(y), ring.Planes(y + 1), image.pixels + image.pitch * y + kChannels * x_begin, x_end - x_begin, weights);
+		}
+	}
+}
+
+// tȎgݍ킹Ƃ̎
+static const CasRowsFunction kCasRowsFunctions[kCasFlagCombinations] =
+{
+	CasRows<4, false, false, false>,
+	CasRows<4, true, false, false>,
+	CasRows<4, false, true, false>,
+	CasRows<4, true, true, false>,
+	CasRows<4, false, false, true>,
+	CasRows<4, true, false, true>,
+	CasRows<4, false, true, true>,
+	CasRows<4, true, true, true>,
+};
+
+// 1`l̏ꍇACAS_SLOW ̗LŌʂ͕ςȂ
+static const CasRowsFunction kCasPlaneRowsFunctions[kCasFlagCombinations] =
+{
+	CasRows<1, false, false, false>,
+	CasRows<1, false, false, false>,
+	CasRows<1, false, true, false>,
+	CasRows<1, false, true, false>,
+	CasRows<1, false, false, true>,
+	CasRows<1, false, false, true>,
+	CasRows<1, false, true, true>,
+	CasRows<1, false, true, true>,
+};
+
+static const CasInPlaceRowsFunction kCasInPlaceRowsFunctions[kCasFlagCombinations] =
+{
+	CasRowsInPlace<4, false, false, false>,
+	CasRowsInPlace<4, true, false, false>,
+	CasRowsInPlace<4, false, true, false>,
+	CasRowsInPlace<4, true, true, false>,
+	CasRowsInPlace<4, false, false, true>,
+	CasRowsInPlace<4, true, false, true>,
+	CasRowsInPlace<4, false, true, true>,
+	CasRowsInPlace<4, true, true, true>,
+};
+
+static const CasInPlaceRowsFunction kCasPlaneInPlaceRowsFunctions[kCasFlagCombinations] =
+{
+	CasRowsInPlace<1, false, false, false>,
+	CasRowsInPlace<1, false, false, false>,
+	CasRowsInPlace<1, false, true, false>,
+	CasRowsInPlace<1, false, true, false>,
+	CasRowsInPlace<1, false, false, true>,
+	CasRowsInPlace<1, false, false, true>,
+	CasRowsInPlace<1, false, true, true>,
+	CasRowsInPlace<1, false, true, true>,
+};
+
+// index ͏Xbh̔ԍŁAďo0A[J[1
+static void RunBands(CasCpuEngine *engine, const CasCpuJob *job, int index)
+{
+	AF1 *ring = job->rings + job->ring_size * index;
+	bool tracing = engine->tracing_ && CasTraceEnabled();
+
+	// 擾т̔ԍ͒Pɑ邽߁A摜̈ʒu͐擪i߂邾ł悢
+	int task = 0;
+
+	for (;;)
+	{
+		int band = engine->next_band_.fetch_add(1);
+		if (job->band_count <= band)
+			break;
+
+		while (job->tasks[task].band_end <= band)
+			++task;
+
+		CAS_PROBE2(band__start, band, index);
+		uint64_t band_start = tracing ? CasTraceNow() : 0;
+		const CasCpuTask &t = job->tasks[task];
+		int y_begin = (band - (0 < task ? job->tasks[task - 1].band_end : 0)) * job->band_rows;
+		int y_end = std::min(y_begin + job->band_rows, t.src.height);
+
+		if (job->in_place_rows)
+		{
+			CasLineBuffer lines;
+			lines.above = job->lines + job->lines_size * band;
+			lines.below = lines.above + job->line_size;
+			lines.column = reinterpret_cast<AF1 *>(lines.below + job->line_size);
+			job->in_place_rows(t.src, lines, t.weights, y_begin, y_end, job->strip_bytes, ring);
+		}
+		else
+		{
+			job->rows(t.src, t.dst, t.weights, y_begin, y_end, job->strip_bytes, ring);
+		}
+
+		// XbhԂ̕΂邽߁AтƂɋԂL^
+		if (tracing)
+			CasTraceSpan("band", "worker", band_start, CasTraceNow(), band);
+		CAS_PROBE2(band__end, band, index);
+	}
+}
+
+static void WorkerMain(CasCpuEngine *engine, int index)
+{
+	// ŒɎsĂAOS̊̂܂܏𑱂
+	if (0 <= engine->node_)
+		CasNumaPinThread(engine->node_);
+
+	uint64_t generation = 0;
+	std::unique_lock<std::mutex> lock(engine->mutex_);
+
+	for (;;)
+	{
+		engine->start_.wait(lock, [&]{return engine->quit_ || generation != engine->generation_;});
+		if (engine->quit_)
+			return;
+
+		generation = engine->generation_;
+		const CasCpuJob *job = engine->job_;
+
+		lock.unlock();
+		RunBands(engine, job, index);
+		lock.lock();
+
+		if (0 == --engine->running_)
+			engine->done_.notify_one();
+	}
+}
+
+// L1f[^LbV̑傫ԂA擾łȂꍇ0
+static size_t L1DataCacheSize()
+{
+#ifdef _WIN32
+	DWORD size = 0;
+	GetLogicalProcessorInformation(nullptr, &size);
+	std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> infos(size / sizeof (SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+	if (infos.empty() || !GetLogicalProcessorInformation(infos.data(), &size))
+		return 0;
+
+	for (const SYSTEM_LOGICAL_PROCESSOR_INFORMATION &info : infos)
+	{
+		if (RelationCache == info.Relationship && 1 == info.Cache.Level && (CacheData == info.Cache.Type || CacheUnified == info.Cache.Type))
+			return info.Cache.Size;
+	}
+
+	return 0;
+#elif defined(_SC_LEVEL1_DCACHE_SIZE)
+	long size = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+	return 0 < size ? static_cast<size_t>(size) : 0;
+#else
+	return 0;
+#endif
+}
+
+// `lɕϊ㒆3sAL1f[^LbV̔Ɏ܂Z̕߂
+// c̔́Ao͂̍sƕϊe[uȂǂ̂߂ɋ󂯂Ă
+static size_t DefaultStripBytes()
+{
+	size_t l1 = L1DataCacheSize();
+	if (!l1)
+		l1 = kDefaultL1DataCacheSize;
+
+	return std::max(kMinStripBytes, l1 / 2 / 3);
+}
+
+CasCpuEngine *CasCpuCreate(int thread_count)
+{
+	return CasCpuCreateOnNode(thread_count, -1);
+}
+
+CasCpuEngine *CasCpuCreateOnNode(int thread_count, int node)
+{
+	std::call_once(g_tables_once, InitTables);
+
+	if (thread_count <= 0)
+	{
+		int node_processors = 0 <= node ? CasNumaProcessorCount(node) : 0;
+		thread_count = 0 < node_processors ? node_processors : std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	CasCpuEngine *engine = new(std::nothrow) CasCpuEngine;
+	if (!engine)
+		return nullptr;
+
+	engine->generation_ = 0;
+	engine->running_ = 0;
+	engine->quit_ = false;
+	engine->job_ = nullptr;
+	engine->next_band_ = 0;
+	engine->strip_bytes_ = DefaultStripBytes();
+	engine->tracing_ = false;
+	engine->weight_table_.valid = false;
+	engine->scratch_ = nullptr;
+	engine->scratch_size_ = 0;
+	CasArenaCreate(&engine->own_scratch_, 0, false);
+	engine->scratch_allocations_ = 0;
+	engine->node_ = node;
+
+	// ďõXbhɉ邽߁A[J[1Ȃ
+	try
+	{
+		for (int i=1; i<thread_count; ++i)
+			engine->workers_.emplace_back(WorkerMain, engine, i);
+	}
+	catch (...)
+	{
+		CasCpuDestroy(engine);
+		return nullptr;
+	}
+
+	return engine;
+}
+
+void CasCpuDestroy(CasCpuEngine *engine)
+{
+	if (!engine)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(engine->mutex_);
+		engine->quit_ = true;
+	}
+	engine->start_.notify_all();
+
+	for (std::thread &worker : engine->workers_)
+		worker.join();
+
+	CasArenaDestroy(&engine->own_scratch_);
+	delete engine;
+}
+
+size_t CasCpuStripBytes(const CasCpuEngine *engine)
+{
+	return engine->strip_bytes_;
+}
+
+void CasCpuSetStripBytes(CasCpuEngine *engine, size_t strip_bytes)
+{
+	engine->strip_bytes_ = strip_bytes ? std::max(kMinStripBytes, strip_bytes) : 0;
+}
+
+void CasCpuSetTracing(CasCpuEngine *engine, bool tracing)
+{
+	engine->tracing_ = tracing;
+}
+
+unsigned CasQualityFlags(int quality)
+{
+	static const unsigned kFlags[kCasQualityLevels] =
+	{
+		kCasSlow | kCasGoSlower | kCasBetterDiagonals,
+		kCasSlow | kCasGoSlower,
+		kCasSlow,
+		0,
+	};
+
+	return kFlags[std::clamp(quality, 0, kCasQualityLevels - 1)];
+}
+
+// 摜̑傫͂Əo͂œł邽߁ACasSetup ̌ʂ̂ĝ peak ̂
+static AF1 CasPeak(float sharpness, int width, int height)
+{
+	varAU4(const0);
+	varAU4(const1);
+	AF1 w = static_cast<AF1>(width);
+	AF1 h = static_cast<AF1>(height);
+
+	CasSetup(const0, const1, sharpness, w, h, w, h);
+
+	return AF1FromBits(const1[0]);
+}
+
+// peak Ɛx\ƂƈقȂꍇ̂݁A\蒼
+static const CasWeight *PrepareWeights(CasWeightTable *table, AF1 peak, unsigned flags)
+{
+	bool go_slower = 0 != (kCasGoSlower & flags);
+
+	if (table->valid && table->peak == peak && table->go_slower == go_slower)
+		return table->weights;
+
+	for (int i=0; i<=kWeightSteps + 1; ++i)
+	{
+		AF1 amp = WeightAmp(i);
+		AF1 w = (go_slower ? ASqrtF1(amp) : CasPrxLoSqrt(amp)) * peak;
+		table->weights[i].w = w;
+		table->weights[i].rcp_weight = go_slower ? ARcpF1(AF1_(1.0) + AF1_(4.0) * w) : CasPrxMedRcp(AF1_(1.0) + AF1_(4.0) * w);
+	}
+
+	table->valid = true;
+	table->go_slower = go_slower;
+	table->peak = peak;
+
+	return table->weights;
+}
+
+// XbhƂ ring_size vf̏zobt@uꍇ́AŜ̃oCg
+static size_t RingsBytes(const CasCpuEngine *engine, size_t ring_size)
+{
+	return ring_size * sizeof (AF1) * (engine->workers_.size() + 1);
+}
+
+// ̏ŏꍇ́A1̑т̍Ɨ̈̃oCg
+// т̒Oƒ̌̍sƁAsƂ̒Z̉E[̉f̐`luAꂼ64oCgPʂɑ
+static size_t InPlaceLinesBytes(int channels, int width, int band_rows)
+{
+	int colors = 4 == channels ? 3 : 1;
+	return CasArenaPitch(static_cast<size_t>(width) * channels) * 2 + CasArenaPitch(sizeof (AF1) * colors * band_rows);
+}
+
+// ̏ŏꍇ̑т̐ƁA1̑т̍s
+// т̋E̍s͍Ɨ̈ɎʂKv邽߁Aт̐̓Xbh܂łƂAeт傫
+static void InPlaceBands(const CasCpuEngine *engine, int height, int *band_count, int *band_rows)
+{
+	int thread_count = static_cast<int>(engine->workers_.size()) + 1;
+	int count = std::min(thread_count, (height + kBandRows - 1) / kBandRows);
+	int rows = (height + count - 1) / count;
+
+	*band_count = (height + rows - 1) / rows;
+	*band_rows = rows;
+}
+
+// size oCg̍Ɨ̈pӂ
+// ďonƗ̈őꍇ͂pAȂꍇ̂݊mۂ
+static uint8_t *PrepareScratch(CasCpuEngine *engine, size_t size)
+{
+	if (size <= engine->scratch_size_)
+		return engine->scratch_;
+
+	CasArena *own = &engine->own_scratch_;
+	if (own->size_ < size)
+	{
+		CasArenaDestroy(own);
+		if (!CasArenaCreateOnNode(own, size, true, engine->node_))
+			return nullptr;
+		++engine->scratch_allocations_;
+	}
+
+	return own->base_;
+}
+
+size_t CasCpuScratchSize(const CasCpuEngine *engine, int channels, int width, int height)
+{
+	if (width <= 0 || height <= 0)
+		return 0;
+
+	int colors = 4 == channels ? 3 : 1;
+	size_t single = RingsBytes(engine, RingSize(colors, StripWidth(engine->strip_bytes_, colors, width)));
+
+	int band_count;
+	int band_rows;
+	InPlaceBands(engine, height, &band_count, &band_rows);
+	size_t in_place = single + InPlaceLinesBytes(channels, width, band_rows) * band_count;
+
+	return std::max(single, in_place);
+}
+
+void CasCpuSetScratch(CasCpuEngine *engine, void *scratch, size_t size)
+{
+	engine->scratch_ = scratch ? static_cast<uint8_t *>(scratch) : nullptr;
+	engine->scratch_size_ = scratch ? size : 0;
+}
+
+uint64_t CasCpuScratchAllocations(const CasCpuEngine *engine)
+{
+	return engine->scratch_allocations_;
+}
+
+static void RunJob(CasCpuEngine *engine, const CasCpuJob &job)
+{
+	if (job.band_count <= 0)
+		return;
+
+	// т1Ȃ΁A[J[Nɏ
+	if (1 == job.band_count || engine->workers_.empty())
+	{
+		engine->next_band_ = 0;
+		RunBands(engine, &job, 0);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(engine->mutex_);
+		engine->job_ = &job;
+		engine->next_band_ = 0;
+		engine->running_ = static_cast<int>(engine->workers_.size());
+		++engine->generation_;
+	}
+	engine->start_.notify_all();
+
+	RunBands(engine, &job, 0);
+
+	std::unique_lock<std::mutex> lock(engine->mutex_);
+	engine->done_.wait(lock, [&]{return 0 == engine->running_;});
+	engine->job_ = nullptr;
+}
+
+static bool RunSingle(CasCpuEngine *engine, CasRowsFunction rows, unsigned flags, int colors, const CasCpuImage *src, const CasCpuImage *dst, float sharpness)
+{
+	if (src->width <= 0 || src->height <= 0)
+		return true;
+
+	size_t ring_size = RingSize(colors, StripWidth(engine->strip_bytes_, colors, src->width));
+	AF1 *rings = reinterpret_cast<AF1 *>(PrepareScratch(engine, RingsBytes(engine, ring_size)));
+	if (!rings)
+		return false;
+
+	CasCpuTask task;
+	task.src = *src;
+	task.dst = *dst;
+	task.weights = PrepareWeights(&engine->weight_table_, CasPeak(sharpness, src->width, src->height), flags);
+	task.band_end = (src->height + kBandRows - 1) / kBandRows;
+
+	CasCpuJob job;
+	job.rows = rows;
+	job.in_place_rows = nullptr;
+	job.tasks = &task;
+	job.task_count = 1;
+	job.band_count = task.band_end;
+	job.band_rows = kBandRows;
+	job.strip_bytes = engine->strip_bytes_;
+	job.lines = nullptr;
+	job.line_size = 0;
+	job.lines_size = 0;
+	job.rings = rings;
+	job.ring_size = ring_size;
+
+	CAS_PROBE5(kernel__start, src->width, src->height, CAS_PROBE_SHARPNESS(sharpness), flags, colors);
+	RunJob(engine, job);
+	CAS_PROBE3(kernel__end, src->width, src->height, flags);
+
+	return true;
+}
+
+static bool RunBatch(CasCpuEngine *engine, CasRowsFunction rows, unsigned flags, int colors, const CasCpuBatchItem *items, int count)
+{
+	std::vector<CasCpuTask> &tasks = engine->tasks_;
+	std::vector<std::unique_ptr<CasWeightTable>> &tables = engine->batch_weight_tables_;
+	int band_count = 0;
+	int max_width = 0;
+	size_t table_count = 0;
+	float last_sharpness = 0.0f;
+	const CasWeight *last_weights = nullptr;
+
+	try
+	{
+		tasks.reserve(count);
+	}
+	catch (...)
+	{
+		return false;
+	}
+	tasks.clear();
+
+	for (int i=0; i<count; ++i)
+	{
+		const CasCpuBatchItem &item = items[i];
+		if (item.src.width <= 0 || item.src.height <= 0)
+			continue;
+
+		// Ƃ߁AȌd݂̕\g
+		if (tasks.empty() || item.sharpness != last_sharpness)
+		{
+			if (tables.size() <= table_count)
+			{
+				CasWeightTable *table = new(std::nothrow) CasWeightTable;
+				if (!table)
+					return false;
+				table->valid = false;
+				try
+				{
+					tables.emplace_back(table);
+				}
+				catch (...)
+				{
+					delete table;
+					return false;
+				}
+			}
+
+			last_sharpness = item.sharpness;
+			last_weights = PrepareWeights(tables[table_count].get(), CasPeak(item.sharpness, item.src.width, item.src.height), flags);
+			++table_count;
+		}
+
+		band_count += (item.src.height + kBandRows - 1) / kBandRows;
+		max_width = std::max(max_width, item.src.width);
+
+		CasCpuTask task;
+		task.src = item.src;
+		task.dst = item.dst;
+		task.weights = last_weights;
+		task.band_end = band_count;
+		tasks.push_back(task);
+	}
+
+	if (!band_count)
+		return true;
+
+	// Z͉̕摜̕ƂƂɑ邽߁AłL摜ɍ킹
+	size_t ring_size = RingSize(colors, StripWidth(engine->strip_bytes_, colors, max_width));
+	AF1 *rings = reinterpret_cast<AF1 *>(PrepareScratch(engine, RingsBytes(engine, ring_size)));
+	if (!rings)
+		return false;
+
+	CasCpuJob job;
+	job.rows = rows;
+	job.in_place_rows = nullptr;
+	job.tasks = tasks.data();
+	job.task_count = static_cast<int>(tasks.size());
+	job.band_count = band_count;
+	job.band_rows = kBandRows;
+	job.strip_bytes = engine->strip_bytes_;
+	job.lines = nullptr;
+	job.line_size = 0;
+	job.lines_size = 0;
+	job.rings = rings;
+	job.ring_size = ring_size;
+
+	CAS_PROBE3(batch__start, job.task_count, band_count, flags);
+	RunJob(engine, job);
+	CAS_PROBE3(batch__end, job.task_count, band_count, flags);
+
+	return true;
+}
+
+static bool RunInPlace(CasCpuEngine *engine, CasInPlaceRowsFunction rows, unsigned flags, int channels, const CasCpuImage *image, float sharpness)
+{
+	if (image->width <= 0 || image->height <= 0)
+		return true;
+
+	int band_count;
+	int band_rows;
+	InPlaceBands(engine, image->height, &band_count, &band_rows);
+
+	// zobt@͒Z̕ƂAтƂ̌̍sƒZ̒[̗͂̌ɒu
+	// тƂ̗̈64oCgPʂɑAтƂɓLbVCLȂ悤ɂ
+	int colors = 4 == channels ? 3 : 1;
+	size_t ring_size = RingSize(colors, StripWidth(engine->strip_bytes_, colors, image->width));
+	size_t rings_bytes = RingsBytes(engine, ring_size);
+	size_t line_size = CasArenaPitch(static_cast<size_t>(image->width) * channels);
+	size_t lines_size = InPlaceLinesBytes(channels, image->width, band_rows);
+	uint8_t *scratch = PrepareScratch(engine, rings_bytes + lines_size * band_count);
+	if (!scratch)
+		return false;
+
+	AF1 *rings = reinterpret_cast<AF1 *>(scratch);
+	uint8_t *lines = scratch + rings_bytes;
+
+	// ̑т㏑OɁAт̒Oƒ̌̍sʂĂ
+	size_t size = static_cast<size_t>(image->width) * channels;
+	for (int band=0; band<band_count; ++band)
+	{
+		int y_begin = band * band_rows;
+		int y_end = std::min(y_begin + band_rows, image->height);
+		uint8_t *above = lines + lines_size * band;
+
+		if (0 < y_begin)
+			memcpy(above, image->pixels + image->pitch * (y_begin - 1), size);
+		if (y_end < image->height)
+			memcpy(above + line_size, image->pixels + image->pitch * y_end, size);
+	}
+
+	CasCpuTask task;
+	task.src = *image;
+	task.dst = *image;
+	task.weights = PrepareWeights(&engine->weight_table_, CasPeak(sharpness, image->width, image->height), flags);
+	task.band_end = band_count;
+
+	CasCpuJob job;
+	job.rows = nullptr;
+	job.in_place_rows = rows;
+	job.tasks = &task;
+	job.task_count = 1;
+	job.band_count = band_count;
+	job.band_rows = band_rows;
+	job.strip_bytes = engine->strip_bytes_;
+	job.lines = lines;
+	job.line_size = line_size;
+	job.lines_size = lines_size;
+	job.rings = rings;
+	job.ring_size = ring_size;
+
+	CAS_PROBE5(kernel__start, image->width, image->height, CAS_PROBE_SHARPNESS(sharpness), flags, colors);
+	RunJob(engine, job);
+	CAS_PROBE3(kernel__end, image->width, image->height, flags);
+
+	return true;
+}
+
+bool CasCpuFilter(CasCpuEngine *engine, const CasCpuImage *src, const CasCpuImage *dst, float sharpness, int quality)
+{
+	unsigned flags = CasQualityFlags(quality);
+	return RunSingle(engine, kCasRowsFunctions[flags], flags, 3, src, dst, sharpness);
+}
+
+bool CasCpuFilterPlane(CasCpuEngine *engine, const CasCpuImage *src, const CasCpuImage *dst, float sharpness, int quality)
+{
+	unsigned flags = CasQualityFlags(quality);
+	return RunSingle(engine, kCasPlaneRowsFunctions[flags], flags, 1, src, dst, sharpness);
+}
+
+bool CasCpuFilterBatch(CasCpuEngine *engine, const CasCpuBatchItem *items, int count, int quality)
+{
+	unsigned flags = CasQualityFlags(quality);
+	return RunBatch(engine, kCasRowsFunctions[flags], flags, 3, items, count);
+}
+
+bool CasCpuFilterPlaneBatch(CasCpuEngine *engine, const CasCpuBatchItem *items, int count, int quality)
+{
+	unsigned flags = CasQualityFlags(quality);
+	return RunBatch(engine, kCasPlaneRowsFunctions[flags], flags, 1, items, count);
+}
+
+bool CasCpuFilterInPlace(CasCpuEngine *engine, const CasCpuImage *image, float sharpness, int quality)
+{
+	unsigned flags = CasQualityFlags(quality);
+	return RunInPlace(engine, kCasInPlaceRowsFunctions[flags], flags, 4, image, sharpness);
+}
+
+bool CasCpuFilterPlaneInPlace(CasCpuEngine *engine, const CasCpuImage *image, float sharpness, int quality)
+{
+	unsigned flags = CasQualityFlags(quality);
+	return RunInPlace(engine, kCasPlaneInPlaceRowsFunctions[flags], flags, 1, image, sharpness);
+}
+
+bool CasCpuFilterFlags(CasCpuEngine *engine, int channels, const CasCpuImage *src, const CasCpuImage *dst, float sharpness, unsigned flags)
+{
+	flags &= kCasFlagCombinations - 1;
+
+	if (4 == channels)
+	{
+		if (!dst)
+			return RunInPlace(engine, kCasInPlaceRowsFunctions[flags], flags, 4, src, sharpness);
+		return RunSingle(engine, kCasRowsFunctions[flags], flags, 3, src, dst, sharpness);
+	}
+
+	if (!dst)
+		return RunInPlace(engine, kCasPlaneInPlaceRowsFunctions[flags], flags, 1, src, sharpness);
+	return RunSingle(engine, kCasPlaneRowsFunctions[flags], flags, 1, src, dst, sharpness);
+}
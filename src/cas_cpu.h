@@ -0,0 +1,105 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+// CAS̕iiK
+// CAS.hlsl  CAS_QUALITY ƓΉŁAiKオ邲ƂɃtOOAyɂȂ
+enum CasQuality
+{
+	kCasQualityBest = 0, // CAS_SLOW, CAS_GO_SLOWER, CAS_BETTER_DIAGONALS
+	kCasQualityHigh, // CAS_SLOW, CAS_GO_SLOWER
+	kCasQualityMedium, // CAS_SLOW
+	kCasQualityFast, // Ȃ (ߎ̋tƕpAd݂͗΂݂̂狁߂)
+	kCasQualityLevels
+};
+
+// ffx_cas.h ̊etO
+enum CasFlags
+{
+	kCasSlow = 1,
+	kCasGoSlower = 2,
+	kCasBetterDiagonals = 4,
+	kCasFlagCombinations = 8
+};
+
+// 8bit ̉摜
+// f͌ďoLApitch 1s̃oCg
+struct CasCpuImage
+{
+	uint8_t *pixels;
+	ptrdiff_t pitch;
+	int width;
+	int height;
+};
+
+// ꊇ摜1
+struct CasCpuBatchItem
+{
+	CasCpuImage src;
+	CasCpuImage dst;
+	float sharpness;
+};
+
+struct CasCpuEngine;
+
+
+// thread_count 0̏ꍇA_vZbT̃Xbhŏ
+CasCpuEngine *CasCpuCreate(int thread_count);
+
+// CasCpuCreate ƓA[J[ NUMA m[h node ̃vZbTɌŒ肵AƗ̈̃m[hɊmۂ
+// thread_count 0̏ꍇ́Ãm[h̘_vZbTƂ
+// ďõXbhɉ邪AŒ͂Ȃ߁AKvłΌďo CasNumaPinThread ŌŒ肷
+CasCpuEngine *CasCpuCreateOnNode(int thread_count, int node);
+void CasCpuDestroy(CasCpuEngine *engine);
+
+// ̍L摜c̒Zɕďꍇ́AZ1s`lɕϊƗ̈̃oCg
+// lL1f[^LbV̑傫狁߂A0ݒ肷ƒZɕȂ
+size_t CasCpuStripBytes(const CasCpuEngine *engine);
+void CasCpuSetStripBytes(CasCpuEngine *engine, size_t strip_bytes);
+
+// тƂ̏̋Ԃ CasTraceSpan ŋL^Ał͋L^Ȃ
+// g[X̓vZXŋL邽߁ACasTraceOpen Ă񂾌ďõGŴݗLɂ
+// ɕςȂ
+void CasCpuSetTracing(CasCpuEngine *engine, bool tracing);
+
+//  widthA heightA`l channels ̉摜ꍇɁACasCpuFilter ȂǂpƗ̈̃oCg
+// Z̕ςꍇ͋ߒ
+size_t CasCpuScratchSize(const CasCpuEngine *engine, int channels, int width, int height);
+
+// Ɨ̈ďonAscratch 64oCgEɑAGWj܂ŕێ
+// nƗ̈őԂ́AɃq[vmۂȂ
+// nullptr nƁAGWgŊmۂ
+void CasCpuSetScratch(CasCpuEngine *engine, void *scratch, size_t size);
+
+// Ɨ̈悪肸AGWgŊmۂ
+// Oɏ\ȍƗ̈nĂ΁AJԂĂȂ
+uint64_t CasCpuScratchAllocations(const CasCpuEngine *engine);
+
+unsigned CasQualityFlags(int quality);
+
+// BGRA  src ǂ݁ACAS̏ʂ dst ɏ
+// src  dst ͓傫ŁA݂ɏdȂȂ
+// Ɨ̈mۂłȂꍇ͋UԂAdst ɂ͏Ȃ
+bool CasCpuFilter(CasCpuEngine *engine, const CasCpuImage *src, const CasCpuImage *dst, float sharpness, int quality);
+
+// CasCpuFilter ƓAsrc  dst PxȂǂ1`l̉摜ƂĈ
+bool CasCpuFilterPlane(CasCpuEngine *engine, const CasCpuImage *src, const CasCpuImage *dst, float sharpness, int quality);
+
+// ̉摜A[J[1Nł܂Ƃ߂ď
+// ȉ摜𑽐ꍇɁA1Ƃ̌ďoׂ̕邽߂ɗp
+// Ɨ̈mۂłȂꍇ͋UԂ
+bool CasCpuFilterBatch(CasCpuEngine *engine, const CasCpuBatchItem *items, int count, int quality);
+bool CasCpuFilterPlaneBatch(CasCpuEngine *engine, const CasCpuBatchItem *items, int count, int quality);
+
+// image ǂ݁ACAS̏ʂ image ㏑
+// o͂̉摜pӂAXbhƂɒZ̕3sƁAтƂɋE2s1񕪂̍Ɨ݂̈̂ŏ
+// Ɨ̈mۂłȂꍇ͋UԂAimage ͕ύXȂ
+bool CasCpuFilterInPlace(CasCpuEngine *engine, const CasCpuImage *image, float sharpness, int quality);
+bool CasCpuFilterPlaneInPlace(CasCpuEngine *engine, const CasCpuImage *image, float sharpness, int quality);
+
+// quality ̑ CasFlags ̑gݍ킹𒼐ڎw肷
+// iiKɑΉȂgݍ킹܂߁Agݍ킹Ƃ̎̂m߂邽߂ɗp
+// channels 4 (BGRA) 1Adst  nullptr ̏ꍇ src ̏ŏ㏑
+bool CasCpuFilterFlags(CasCpuEngine *engine, int channels, const CasCpuImage *src, const CasCpuImage *dst, float sharpness, unsigned flags);
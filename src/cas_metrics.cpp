@@ -0,0 +1,371 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#ifndef SOCK_CLOEXEC
+#define SOCK_CLOEXEC 0
+#endif
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cas_metrics.h"
+
+
+// t@CɏԊu
+static const int kMetricsFileIntervalMs = 5000;
+
+// \Pbg̐ڑvǂނ܂ő҂
+static const int kMetricsRequestTimeoutMs = 100;
+
+static const char kMetricsSocketPrefix[] = "unix:";
+
+struct CasMetricsSourceEntry
+{
+	const CasMetricsSource *source;
+	int instance; // o^̔ԍAxɗp
+};
+
+struct CasMetricsState
+{
+	std::mutex control; // CasMetricsStart  CasMetricsStop 𒼗ɂAXbh̏I҂Ԃێ
+	std::mutex mutex; // ȉׂ̂Ă
+	std::condition_variable changed; // J̏IXbhɒʒm
+	std::vector<CasMetricsSourceEntry> sources;
+	int next_instance;
+	int references;
+	bool quit;
+	std::string path; // \Pbgt@C̃pX
+	bool socket;
+	std::thread exporter;
+#ifndef _WIN32
+	int listen_fd;
+	int wake_fds[2]; // J̏IɃ\Pbg̑ҋ@N߂̃pCv
+#endif
+};
+
+static CasMetricsState g_metrics;
+
+
+static void AppendLine(std::string *text, const char *format, ...)
+{
+	char line[512];
+	va_list args;
+
+	va_start(args, format);
+	int length = vsnprintf(line, sizeof (line), format, args);
+	va_end(args);
+
+	if (0 < length)
+		text->append(line, std::min(static_cast<size_t>(length), sizeof (line) - 1));
+}
+
+std::string CasMetricsRender()
+{
+	std::string text;
+	std::lock_guard<std::mutex> lock(g_metrics.mutex);
+
+	text += "# HELP cas_frames_total Frames passed to the filter.\n# TYPE cas_frames_total counter\n";
+	for (const CasMetricsSourceEntry &entry : g_metrics.sources)
+		AppendLine(&text, "cas_frames_total{instance=\"%d\",backend=\"%s\"} %llu\n", entry.instance, entry.source->backend,
+			static_cast<unsigned long long>(entry.source->stages[kCasStageTotal].count_.load(std::memory_order_relaxed)));
+
+	text += "# HELP cas_frame_pixels Pixels per frame, multiply with the frame rate for throughput.\n# TYPE cas_frame_pixels gauge\n";
+	for (const CasMetricsSourceEntry &entry : g_metrics.sources)
+		AppendLine(&text, "cas_frame_pixels{instance=\"%d\",backend=\"%s\"} %lld\n", entry.instance, entry.source->backend,
+			static_cast<long long>(entry.source->width) * entry.source->height);
+
+	text += "# HELP cas_quality_tier Current quality tier, 0 is best and 4 is passthrough.\n# TYPE cas_quality_tier gauge\n";
+	for (const CasMetricsSourceEntry &entry : g_metrics.sources)
+		AppendLine(&text, "cas_quality_tier{instance=\"%d\",backend=\"%s\"} %d\n", entry.instance, entry.source->backend,
+			entry.source->quality->load(std::memory_order_relaxed));
+
+	text += "# HELP cas_stage_seconds Time spent in each stage of a frame.\n# TYPE cas_stage_seconds summary\n";
+	for (const CasMetricsSourceEntry &entry : g_metrics.sources)
+	{
+		for (int stage=0; stage<kCasStages; ++stage)
+		{
+			const CasStageStats *stats = &entry.source->stages[stage];
+			uint64_t count = stats->count_.load(std::memory_order_relaxed);
+			if (!count)
+				continue;
+
+			const char *name = CasStageName(stage);
+			AppendLine(&text, "cas_stage_seconds{instance=\"%d\",backend=\"%s\",stage=\"%s\",quantile=\"0.5\"} %.6f\n", entry.instance, entry.source->backend, name, CasStatsPercentile(stats, 0.50) * 1e-6);
+			AppendLine(&text, "cas_stage_seconds{instance=\"%d\",backend=\"%s\",stage=\"%s\",quantile=\"0.99\"} %.6f\n", entry.instance, entry.source->backend, name, CasStatsPercentile(stats, 0.99) * 1e-6);
+			AppendLine(&text, "cas_stage_seconds_sum{instance=\"%d\",backend=\"%s\",stage=\"%s\"} %.6f\n", entry.instance, entry.source->backend, name, stats->sum_.load(std::memory_order_relaxed) * 1e-6);
+			AppendLine(&text, "cas_stage_seconds_count{instance=\"%d\",backend=\"%s\",stage=\"%s\"} %llu\n", entry.instance, entry.source->backend, name, static_cast<unsigned long long>(count));
+		}
+	}
+
+	text += "# HELP cas_events_total Frames that could not be filtered, by reason.\n# TYPE cas_events_total counter\n";
+	for (const CasMetricsSourceEntry &entry : g_metrics.sources)
+	{
+		for (int event=0; event<entry.source->event_count; ++event)
+			AppendLine(&text, "cas_events_total{instance=\"%d\",backend=\"%s\",event=\"%s\"} %llu\n", entry.instance, entry.source->backend, entry.source->event_names[event],
+				static_cast<unsigned long long>(entry.source->events[event].load(std::memory_order_relaxed)));
+	}
+
+	return text;
+}
+
+// ꎞt@CɏĂuAǂޑ̃t@Cǂ܂Ȃ悤ɂ
+static void WriteMetricsFile(const std::string &path)
+{
+	std::string text = CasMetricsRender();
+	std::string temporary = path + ".tmp";
+
+	FILE *file = fopen(temporary.c_str(), "wb");
+	if (!file)
+		return;
+
+	bool written = text.size() == fwrite(text.data(), 1, text.size(), file);
+	if (0 != fclose(file) || !written)
+	{
+		remove(temporary.c_str());
+		return;
+	}
+
+#ifdef _WIN32
+	MoveFileExA(temporary.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING);
+#else
+	rename(temporary.c_str(), path.c_str());
+#endif
+}
+
+static void FileExporterMain()
+{
+	std::unique_lock<std::mutex> lock(g_metrics.mutex);
+
+	while (!g_metrics.quit)
+	{
+		std::string path = g_metrics.path;
+		lock.unlock();
+		WriteMetricsFile(path);
+		lock.lock();
+
+		g_metrics.changed.wait_for(lock, std::chrono::milliseconds(kMetricsFileIntervalMs), []{return g_metrics.quit;});
+	}
+
+	// I̒lc
+	std::string path = g_metrics.path;
+	lock.unlock();
+	WriteMetricsFile(path);
+}
+
+#ifndef _WIN32
+// ڑƂɗvǂݎ̂āAHTTP̉ƂēvԂ
+// curl --unix-socket <pX> http://localhost/metrics Ȃǂœǂ߂
+static void ServeConnection(int fd)
+{
+	struct pollfd request = {fd, POLLIN, 0};
+	if (0 < poll(&request, 1, kMetricsRequestTimeoutMs))
+	{
+		char buffer[1024];
+		ssize_t received = recv(fd, buffer, sizeof (buffer), MSG_DONTWAIT);
+		(void)received;
+	}
+
+	std::string body = CasMetricsRender();
+	char header[128];
+	int header_length = snprintf(header, sizeof (header), "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %zu\r\n\r\n", body.size());
+	std::string response(header, header_length);
+	response += body;
+
+	const char *data = response.data();
+	size_t remaining = response.size();
+	while (remaining)
+	{
+		ssize_t sent = send(fd, data, remaining, MSG_NOSIGNAL);
+		if (sent <= 0)
+			break;
+		data += sent;
+		remaining -= static_cast<size_t>(sent);
+	}
+}
+
+static void SocketExporterMain(int listen_fd, int wake_fd)
+{
+	for (;;)
+	{
+		struct pollfd fds[2] = {{listen_fd, POLLIN, 0}, {wake_fd, POLLIN, 0}};
+		if (poll(fds, 2, -1) < 0)
+			continue;
+		if (fds[1].revents)
+			break;
+		if (!(fds[0].revents & POLLIN))
+			continue;
+
+		int fd = accept(listen_fd, nullptr, nullptr);
+		if (fd < 0)
+			continue;
+		ServeConnection(fd);
+		close(fd);
+	}
+}
+
+static int OpenMetricsSocket(const std::string &path)
+{
+	struct sockaddr_un address;
+	if (sizeof (address.sun_path) <= path.size())
+		return -1;
+
+	memset(&address, 0, sizeof (address));
+	address.sun_family = AF_UNIX;
+	memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+	int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		return -1;
+
+	// ÕvZXc\Pbg͎gȂ߁A폜Ă
+	unlink(path.c_str());
+	if (0 != bind(fd, reinterpret_cast<struct sockaddr *>(&address), sizeof (address)) || 0 != listen(fd, 8))
+	{
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+#endif
+
+bool CasMetricsStart(const char *target)
+{
+	std::lock_guard<std::mutex> control(g_metrics.control);
+	std::lock_guard<std::mutex> lock(g_metrics.mutex);
+
+	if (g_metrics.references)
+	{
+		++g_metrics.references;
+		return true;
+	}
+
+	size_t prefix_length = sizeof (kMetricsSocketPrefix) - 1;
+	g_metrics.socket = 0 == strncmp(target, kMetricsSocketPrefix, prefix_length);
+	g_metrics.path = g_metrics.socket ? target + prefix_length : target;
+	g_metrics.quit = false;
+	if (g_metrics.path.empty())
+		return false;
+
+	try
+	{
+		if (!g_metrics.socket)
+		{
+			g_metrics.exporter = std::thread(FileExporterMain);
+		}
+		else
+		{
+#ifdef _WIN32
+			return false;
+#else
+			g_metrics.listen_fd = OpenMetricsSocket(g_metrics.path);
+			if (g_metrics.listen_fd < 0)
+				return false;
+			if (0 != pipe(g_metrics.wake_fds))
+			{
+				close(g_metrics.listen_fd);
+				unlink(g_metrics.path.c_str());
+				return false;
+			}
+			g_metrics.exporter = std::thread(SocketExporterMain, g_metrics.listen_fd, g_metrics.wake_fds[0]);
+#endif
+		}
+	}
+	catch (...)
+	{
+#ifndef _WIN32
+		if (g_metrics.socket)
+		{
+			close(g_metrics.listen_fd);
+			close(g_metrics.wake_fds[0]);
+			close(g_metrics.wake_fds[1]);
+			unlink(g_metrics.path.c_str());
+		}
+#endif
+		return false;
+	}
+
+	g_metrics.references = 1;
+
+	return true;
+}
+
+void CasMetricsStop()
+{
+	std::lock_guard<std::mutex> control(g_metrics.control);
+	std::thread exporter;
+
+	{
+		std::lock_guard<std::mutex> lock(g_metrics.mutex);
+		if (!g_metrics.references || --g_metrics.references)
+			return;
+
+		g_metrics.quit = true;
+		exporter = std::move(g_metrics.exporter);
+#ifndef _WIN32
+		if (g_metrics.socket)
+		{
+			char wake = 0;
+			ssize_t written = write(g_metrics.wake_fds[1], &wake, 1);
+			(void)written;
+		}
+#endif
+	}
+	g_metrics.changed.notify_all();
+
+	// Xbh͓vۂ mutex 邽߁Amutex 𗣂Ă҂
+	exporter.join();
+
+#ifndef _WIN32
+	if (g_metrics.socket)
+	{
+		close(g_metrics.listen_fd);
+		close(g_metrics.wake_fds[0]);
+		close(g_metrics.wake_fds[1]);
+		unlink(g_metrics.path.c_str());
+	}
+#endif
+}
+
+bool CasMetricsRegister(const CasMetricsSource *source)
+{
+	std::lock_guard<std::mutex> lock(g_metrics.mutex);
+
+	try
+	{
+		g_metrics.sources.push_back({source, ++g_metrics.next_instance});
+	}
+	catch (...)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+void CasMetricsUnregister(const CasMetricsSource *source)
+{
+	std::lock_guard<std::mutex> lock(g_metrics.mutex);
+
+	std::vector<CasMetricsSourceEntry> &sources = g_metrics.sources;
+	sources.erase(std::remove_if(sources.begin(), sources.end(), [&](const CasMetricsSourceEntry &entry){return entry.source == source;}), sources.end());
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+
+#include "cas_stats.h"
+
+
+// Prometheus ̃eLXg`ŁAvZXׂ̂ẴtB^̓vJ
+// J "unix:<pX>" ̏ꍇUnixhC\Pbg (HTTPŉ)AȊO̓t@C (Ԋuŏ)
+// J͐p̃XbhsAtB^̏̓bNȂ
+
+// J1̃tB^̓v
+// e|C^̎wĺAo^܂ŌďoێAbN炸ɍXV
+struct CasMetricsSource
+{
+	const char *backend; // "cpu"  "d3d11"
+	int width;
+	int height;
+	const CasStageStats *stages; // kCasStages Al̓}CNb
+	const std::atomic<uint64_t> *events; // ُ킲Ƃ̗݌v̉
+	const char *const *event_names; // Prometheus ̃xlɗp閼O
+	int event_count;
+	const std::atomic<int> *quality; // ݂̕iiK
+};
+
+// JJn
+// vZX1̂݌JAɊJnĂꍇ target 𖳎ĎQƂ𐔂݂̂Ƃ
+bool CasMetricsStart(const char *target);
+
+// CasMetricsStart Ɠ񐔌ĂԂƁAJI
+void CasMetricsStop();
+
+// source J̑ΏۂɉAJJnĂȂĂo^ł
+// o^Ɖ̂݃bN邽߁AtB^ Open  Close ŌĂ
+bool CasMetricsRegister(const CasMetricsSource *source);
+void CasMetricsUnregister(const CasMetricsSource *source);
+
+// o^ς݂̓v Prometheus ̃eLXg`ŏ
+std::string CasMetricsRender();
@@ -0,0 +1,146 @@
+#include <stdio.h>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+#include <algorithm>
+
+#include "cas_numa.h"
+
+
+#if defined(__linux__)
+// mbind ̕jAlinux/mempolicy.h Ɠl
+static const int kMpolPreferred = 1;
+
+// "0-3,8-11" ̌`̈ꗗǂ݁A܂܂ԍƂ function Ă
+template <typename Function>
+static bool ReadList(const char *path, Function function)
+{
+	FILE *file = fopen(path, "r");
+	if (!file)
+		return false;
+
+	int first;
+	bool found = false;
+	while (1 == fscanf(file, "%d", &first))
+	{
+		int last = first;
+		int c = fgetc(file);
+		if ('-' == c)
+		{
+			if (1 != fscanf(file, "%d", &last))
+				break;
+			c = fgetc(file);
+		}
+
+		for (int i=first; i<=last; ++i)
+			function(i);
+		found = true;
+
+		if (',' != c)
+			break;
+	}
+
+	fclose(file);
+
+	return found;
+}
+
+// m[h node ̘_vZbT̏W
+static bool NodeCpuSet(int node, cpu_set_t *set)
+{
+	char path[64];
+	snprintf(path, sizeof (path), "/sys/devices/system/node/node%d/cpulist", node);
+
+	CPU_ZERO(set);
+	return ReadList(path, [&](int cpu){if (cpu < CPU_SETSIZE) CPU_SET(cpu, set);});
+}
+#endif
+
+int CasNumaNodeCount()
+{
+#ifdef _WIN32
+	ULONG highest = 0;
+	if (!GetNumaHighestNodeNumber(&highest))
+		return 1;
+	return static_cast<int>(highest) + 1;
+#elif defined(__linux__)
+	int count = 0;
+	if (!ReadList("/sys/devices/system/node/online", [&](int node){count = std::max(count, node + 1);}))
+		return 1;
+	return std::max(count, 1);
+#else
+	return 1;
+#endif
+}
+
+int CasNumaProcessorCount(int node)
+{
+	if (node < 0)
+		return 0;
+
+#ifdef _WIN32
+	GROUP_AFFINITY affinity{};
+	if (!GetNumaNodeProcessorMaskEx(static_cast<USHORT>(node), &affinity))
+		return 0;
+
+	int count = 0;
+	for (KAFFINITY mask=affinity.Mask; mask; mask&=mask-1)
+		++count;
+	return count;
+#elif defined(__linux__)
+	cpu_set_t set;
+	if (!NodeCpuSet(node, &set))
+		return 0;
+	return CPU_COUNT(&set);
+#else
+	return 0;
+#endif
+}
+
+bool CasNumaPinThread(int node)
+{
+	if (node < 0)
+		return false;
+
+#ifdef _WIN32
+	GROUP_AFFINITY affinity{};
+	if (!GetNumaNodeProcessorMaskEx(static_cast<USHORT>(node), &affinity) || !affinity.Mask)
+		return false;
+	return 0 != SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr);
+#elif defined(__linux__)
+	cpu_set_t set;
+	if (!NodeCpuSet(node, &set) || !CPU_COUNT(&set))
+		return false;
+	return 0 == pthread_setaffinity_np(pthread_self(), sizeof (set), &set);
+#else
+	return false;
+#endif
+}
+
+bool CasNumaBindMemory(void *addr, size_t size, int node)
+{
+	if (node < 0)
+		return false;
+
+#if defined(__linux__) && defined(SYS_mbind)
+	// ɌŒ肷ƁAm[h̃ȂꍇɊmۂɎs邽߁AD悷wɂƂǂ߂
+	static const int kMaskBits = 8 * sizeof (unsigned long);
+	unsigned long mask[4] = {};
+	if (4 * kMaskBits <= node)
+		return false;
+	mask[node / kMaskBits] = 1UL << (node % kMaskBits);
+
+	return 0 == syscall(SYS_mbind, addr, size, kMpolPreferred, mask, 4 * kMaskBits + 1, 0);
+#else
+	// Windows ł́AmیɃm[hςȂ߁AVirtualAllocExNuma Ŋmۂ
+	return false;
+#endif
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stddef.h>
+
+
+// NUMAm[hւ̃Xbhƃ̊
+// 2\Pbg̊ł́Aʂ̃\Pbg̃ǂނƑш悪xɂȂ邽߁A[J[Ƃ̉摜𓯂m[hɒu
+// NUMAɑΉȂł́Am[h0݂̂ƂĈA͉Ɏs
+
+// NUMAm[h̐A擾łȂꍇ1
+int CasNumaNodeCount();
+
+// m[h node ̘_vZbTA擾łȂꍇ0
+int CasNumaProcessorCount(int node);
+
+// ďõXbhAm[h node ̘_vZbT݂̂œ悤ɂ
+// m[ĥǂ̘_vZbTœOSɔC
+bool CasNumaPinThread(int node);
+
+// addr  size oCg̃y[WAm[h node ̃Ɋ蓖Ă
+// y[Wɏ߂ďOɌĂԁAaddr ̓y[WEɑ
+// m[h̃Ȃꍇ́Ãm[h̃p
+bool CasNumaBindMemory(void *addr, size_t size, int node);
@@ -0,0 +1,228 @@
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "cas_arena.h"
+#include "cas_numa.h"
+#include "cas_pipeline.h"
+#include "cas_queue.h"
+#include "cas_trace.h"
+
+
+// t[Ƃ̘̏g
+// g͓ɏzĎg߁AłÂt[͏ head_ ̘gɂ
+// 1̘gɓɓt[1݂̂̂߁Aǂ̃L[eʂ1ő
+struct CasCpuSlot
+{
+	CasCpuSlot()
+		: jobs(1),
+		  results(1)
+	{
+	}
+
+	std::thread worker;
+	int index; // g̔ԍ
+	CasCpuEngine *engine;
+	SpscQueue<bool> jobs; // ďog̃XbhցA^͓AU͏I
+	SpscQueue<bool> results; // g̃XbhďoցAƗ̈mۂłAdst ɏꍇ͐^
+	bool skip; // Aۂ߂ɕׂ
+	CasCpuImage src;
+	CasCpuImage dst;
+	float sharpness;
+	int quality;
+	void *user_data;
+};
+
+// Ǝ͌ďo1Xbĥ݂sAegƂ͘gƂ̃L[ł̂ݎ󂯓n
+// head_  pending_ ͌ďô݂ǂݏ邽߁AbNȂ
+struct CasCpuPipeline
+{
+	int node_; // g̃XbhŒ肷NUMAm[hȀꍇ͌Œ肵Ȃ
+	bool tracing_; // gƂ̋ԂL^ȂOɏ߁AL[ʂĘg̃Xbh猩
+	int head_; // łÂt[̘g
+	int pending_; // ς݂Ŏ󂯎ĂȂt[
+	std::vector<std::unique_ptr<CasCpuSlot>> slots_;
+};
+
+
+static void SlotMain(CasCpuPipeline *pipeline, CasCpuSlot *slot)
+{
+	if (0 <= pipeline->node_)
+		CasNumaPinThread(pipeline->node_);
+
+	while (slot->jobs.Pop())
+	{
+		// Ȃt[́Â܂܏ÎƂ
+		if (slot->skip)
+		{
+			slot->results.Push(true);
+			continue;
+		}
+
+		bool tracing = pipeline->tracing_ && CasTraceEnabled();
+		uint64_t start = tracing ? CasTraceNow() : 0;
+		bool filtered = CasCpuFilter(slot->engine, &slot->src, &slot->dst, slot->sharpness, slot->quality);
+		if (tracing)
+			CasTraceSpan("slot", "pipeline", start, CasTraceNow(), slot->index);
+
+		slot->results.Push(filtered);
+	}
+}
+
+CasCpuPipeline *CasCpuPipelineCreate(int frame_count, int thread_count)
+{
+	return CasCpuPipelineCreateOnNode(frame_count, thread_count, -1);
+}
+
+CasCpuPipeline *CasCpuPipelineCreateOnNode(int frame_count, int thread_count, int node)
+{
+	if (frame_count <= 0)
+		return nullptr;
+
+	if (thread_count <= 0)
+	{
+		int node_processors = 0 <= node ? CasNumaProcessorCount(node) : 0;
+		thread_count = 0 < node_processors ? node_processors : std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	CasCpuPipeline *pipeline = new(std::nothrow) CasCpuPipeline;
+	if (!pipeline)
+		return nullptr;
+
+	pipeline->node_ = node;
+	pipeline->tracing_ = false;
+	pipeline->head_ = 0;
+	pipeline->pending_ = 0;
+
+	// g̃Xbhɉ邽߁AeGW̃Xbh͘g̃Xbh܂߂Ƃ
+	int frame_threads = std::max(1, thread_count / frame_count);
+
+	try
+	{
+		for (int i=0; i<frame_count; ++i)
+		{
+			pipeline->slots_.push_back(std::make_unique<CasCpuSlot>());
+			CasCpuSlot *slot = pipeline->slots_.back().get();
+			slot->index = i;
+			slot->engine = CasCpuCreateOnNode(frame_threads, node);
+			if (!slot->engine)
+				throw std::bad_alloc();
+			slot->worker = std::thread(SlotMain, pipeline, slot);
+		}
+	}
+	catch (...)
+	{
+		CasCpuPipelineDestroy(pipeline);
+		return nullptr;
+	}
+
+	return pipeline;
+}
+
+void CasCpuPipelineDestroy(CasCpuPipeline *pipeline)
+{
+	if (!pipeline)
+		return;
+
+	// ̃t[͏Î҂A󂯎炸Ɏ̂Ă
+	for (std::unique_ptr<CasCpuSlot> &slot : pipeline->slots_)
+	{
+		if (slot->worker.joinable())
+		{
+			slot->jobs.Push(false);
+			slot->worker.join();
+		}
+		CasCpuDestroy(slot->engine);
+	}
+
+	delete pipeline;
+}
+
+int CasCpuPipelineDepth(const CasCpuPipeline *pipeline)
+{
+	return static_cast<int>(pipeline->slots_.size());
+}
+
+size_t CasCpuPipelineScratchSize(const CasCpuPipeline *pipeline, int width, int height)
+{
+	// eGW̃Xbh͓ł邽߁AKvȍƗ̈ɂȂ
+	size_t slot_size = CasArenaPitch(CasCpuScratchSize(pipeline->slots_[0]->engine, 4, width, height));
+	return slot_size * pipeline->slots_.size();
+}
+
+void CasCpuPipelineSetScratch(CasCpuPipeline *pipeline, void *scratch, size_t size)
+{
+	size_t slot_size = size / pipeline->slots_.size() & ~(kCasArenaAlignment - 1);
+
+	for (size_t i=0; i<pipeline->slots_.size(); ++i)
+		CasCpuSetScratch(pipeline->slots_[i]->engine, scratch ? static_cast<uint8_t *>(scratch) + slot_size * i : nullptr, slot_size);
+}
+
+void CasCpuPipelineSetTracing(CasCpuPipeline *pipeline, bool tracing)
+{
+	// g̃Xbh͓󂯎Ăǂނ߁A̓甽f
+	pipeline->tracing_ = tracing;
+	for (std::unique_ptr<CasCpuSlot> &slot : pipeline->slots_)
+		CasCpuSetTracing(slot->engine, tracing);
+}
+
+uint64_t CasCpuPipelineScratchAllocations(const CasCpuPipeline *pipeline)
+{
+	uint64_t count = 0;
+	for (const std::unique_ptr<CasCpuSlot> &slot : pipeline->slots_)
+		count += CasCpuScratchAllocations(slot->engine);
+
+	return count;
+}
+
+int CasCpuPipelinePending(const CasCpuPipeline *pipeline)
+{
+	return pipeline->pending_;
+}
+
+bool CasCpuPipelineSubmit(CasCpuPipeline *pipeline, const CasCpuImage *src, const CasCpuImage *dst, float sharpness, int quality, void *user_data)
+{
+	int depth = static_cast<int>(pipeline->slots_.size());
+	if (depth <= pipeline->pending_)
+		return false;
+
+	CasCpuSlot *slot = pipeline->slots_[(pipeline->head_ + pipeline->pending_) % depth].get();
+	slot->user_data = user_data;
+	slot->skip = !src;
+	if (src)
+	{
+		slot->src = *src;
+		slot->dst = *dst;
+		slot->sharpness = sharpness;
+		slot->quality = quality;
+	}
+	++pipeline->pending_;
+
+	// g͎󂯎܂ōĂюgȂ߁Ajobs ͋󂢂ĂA҂ɓ
+	slot->jobs.Push(true);
+
+	return true;
+}
+
+bool CasCpuPipelineReceive(CasCpuPipeline *pipeline, bool wait, void **user_data, bool *filtered)
+{
+	if (!pipeline->pending_)
+		return false;
+
+	CasCpuSlot *slot = pipeline->slots_[pipeline->head_].get();
+	bool slot_filtered;
+	if (wait)
+		slot_filtered = slot->results.Pop();
+	else if (!slot->results.TryPop(&slot_filtered))
+		return false;
+
+	*user_data = slot->user_data;
+	if (filtered)
+		*filtered = slot_filtered;
+	pipeline->head_ = (pipeline->head_ + 1) % static_cast<int>(pipeline->slots_.size());
+	--pipeline->pending_;
+
+	return true;
+}
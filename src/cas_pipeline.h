@@ -0,0 +1,51 @@
+#pragma once
+
+#include "cas_cpu.h"
+
+
+// ̃t[ʁX̃XbhœɏAɎ󂯎pCvC
+// ȃt[1тɕĂxȂ߁At[Pʂŕɏ
+// ɏt[ K ƂƁAx K - 1 t[
+// Ǝ͘gƂ SpscQueue Ŏ󂯓nAbNȂ߁ASubmitAReceiveAPending ͓XbhĂ
+struct CasCpuPipeline;
+
+
+// frame_count ̃t[𓯎ɏ
+// thread_count ͑Ŝ̃XbhŁA0̏ꍇ͘_vZbTƂAt[Ƃɓ
+CasCpuPipeline *CasCpuPipelineCreate(int frame_count, int thread_count);
+
+// CasCpuPipelineCreate ƓAg̃XbhƊeGW̃[J[ NUMA m[h node ɌŒ肷
+// thread_count 0̏ꍇ́Ãm[h̘_vZbTƂ
+CasCpuPipeline *CasCpuPipelineCreateOnNode(int frame_count, int thread_count, int node);
+void CasCpuPipelineDestroy(CasCpuPipeline *pipeline);
+
+// ɏt[
+int CasCpuPipelineDepth(const CasCpuPipeline *pipeline);
+
+//  widthA height BGRÃt[ꍇ́ASt[̍Ɨ̈̃oCg
+size_t CasCpuPipelineScratchSize(const CasCpuPipeline *pipeline, int width, int height);
+
+// Ɨ̈ďonAt[ƂɓĊeGWɓn
+// scratch 64oCgEɑApCvCj܂ŕێ
+void CasCpuPipelineSetScratch(CasCpuPipeline *pipeline, void *scratch, size_t size);
+
+// gƂ̏̋ԂƁAeGW̑тƂ̋Ԃ CasTraceSpan ŋL^Ał͋L^Ȃ
+// ɕςȂ
+void CasCpuPipelineSetTracing(CasCpuPipeline *pipeline, bool tracing);
+
+// eGWƗ̈gŊmۂ񐔂̍v
+uint64_t CasCpuPipelineScratchAllocations(const CasCpuPipeline *pipeline);
+
+// ς݂ŁA܂󂯎ĂȂt[
+int CasCpuPipelinePending(const CasCpuPipeline *pipeline);
+
+// CasCpuFilter ƓA󂢂ĂXbhŊJn
+// src  nullptr ̏ꍇ͏Aۂ߂ user_data ׂ
+// ς݂̃t[ Depth ɒBĂꍇ false Ԃ
+// src  dst ̉f́A󂯎܂Ōďoێ
+bool CasCpuPipelineSubmit(CasCpuPipeline *pipeline, const CasCpuImage *src, const CasCpuImage *dst, float sharpness, int quality, void *user_data);
+
+// łÂt[̏IĂ΁A user_data Ԃ
+// wait ^̏ꍇ͏I܂ő҂Aς݂̃t[ꍇ false Ԃ
+// filtered  nullptr łȂꍇAƗ̈mۂł dst ɏȂt[ł͋U
+bool CasCpuPipelineReceive(CasCpuPipeline *pipeline, bool wait, void **user_data, bool *filtered);
@@ -0,0 +1,24 @@
+#pragma once
+
+// USDT ([UԂ̐ÓIg[X|Cg)
+// s̃v[[ bpftrace ȂǂォڑAċNɏԂ̕zȂǂ悤ɂ
+// sys/sdt.h ꍇ (CAS_HAVE_SDT) ̂ݖߍ݁AڑĂȂԂׂ̕ nop 1ƈ̌vẐ
+// voC_ cas ŁAbpftrace ł usdt:<CũpX>:cas:<O> Ǝw肷
+// ݂͐̂ƂA1000{œn
+
+#if CAS_HAVE_SDT
+#include <sys/sdt.h>
+
+#define CAS_PROBE2(name, a, b) DTRACE_PROBE2(cas, name, a, b)
+#define CAS_PROBE3(name, a, b, c) DTRACE_PROBE3(cas, name, a, b, c)
+#define CAS_PROBE5(name, a, b, c, d, e) DTRACE_PROBE5(cas, name, a, b, c, d, e)
+#define CAS_PROBE6(name, a, b, c, d, e, f) DTRACE_PROBE6(cas, name, a, b, c, d, e, f)
+#else
+#define CAS_PROBE2(name, a, b) do {} while (0)
+#define CAS_PROBE3(name, a, b, c) do {} while (0)
+#define CAS_PROBE5(name, a, b, c, d, e) do {} while (0)
+#define CAS_PROBE6(name, a, b, c, d, e, f) do {} while (0)
+#endif
+
+// v[üɓnɕϊ
+#define CAS_PROBE_SHARPNESS(sharpness) static_cast<int>((sharpness) * 1000.0f + 0.5f)
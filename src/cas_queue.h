@@ -0,0 +1,173 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
+#define CAS_QUEUE_PAUSE() _mm_pause()
+#else
+#define CAS_QUEUE_PAUSE() std::this_thread::yield()
+#endif
+
+
+// ƓǏo1Xbh́ÂL[
+// vf͍쐬Ɋmۂzobt@ɒuAPush  Pop ̓bNȂ
+// t̏ꍇ Push Ȁꍇ Pop ҂
+// ҂ꍇ͂΂炭肵Ă疰AĂ鑊肪ꍇ̂ mutex ċN
+template <typename T>
+class SpscQueue
+{
+public:
+	// capacity 2ׂ̂ɐ؂グ
+	explicit SpscQueue(size_t capacity)
+		: spin_count_(1 < std::thread::hardware_concurrency() ? kSpinCount : 0),
+		  mask_(RoundUp(capacity) - 1),
+		  items_(mask_ + 1),
+		  head_(0),
+		  tail_(0),
+		  cached_head_(0),
+		  cached_tail_(0),
+		  sleepers_(0)
+	{
+	}
+
+	SpscQueue(const SpscQueue &) = delete;
+	SpscQueue &operator=(const SpscQueue &) = delete;
+
+	// ݂̂Ă
+	bool TryPush(T value)
+	{
+		if (!Produce(value))
+			return false;
+		Wake();
+		return true;
+	}
+
+	// Ǐô݂Ă
+	bool TryPop(T *value)
+	{
+		if (!Consume(value))
+			return false;
+		Wake();
+		return true;
+	}
+
+	void Push(T value)
+	{
+		Wait([&]{return Produce(value);});
+		Wake();
+	}
+
+	T Pop()
+	{
+		T value;
+		Wait([&]{return Consume(&value);});
+		Wake();
+		return value;
+	}
+
+private:
+	// 肷񐔁A1̃t[̎n͂̊ԂɏI邱Ƃ
+	// _vZbT1̏ꍇ́A肵Ă肪i܂Ȃ߁Aɖ
+	static const int kSpinCount = 256;
+
+	static size_t RoundUp(size_t capacity)
+	{
+		size_t size = 1;
+		while (size < capacity)
+			size <<= 1;
+		return size;
+	}
+
+	// ̈ʒui߂AN̂͌ďos
+	bool Produce(T value)
+	{
+		size_t tail = tail_.load(std::memory_order_relaxed);
+
+		// ǏöʒúAtɌꍇ̂ݓǂݒ
+		if (mask_ < tail - cached_head_)
+		{
+			cached_head_ = head_.load(std::memory_order_acquire);
+			if (mask_ < tail - cached_head_)
+				return false;
+		}
+
+		items_[tail & mask_] = value;
+		tail_.store(tail + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	// Ǐöʒui߂AN̂͌ďos
+	bool Consume(T *value)
+	{
+		size_t head = head_.load(std::memory_order_relaxed);
+
+		// ̈ʒúAɌꍇ̂ݓǂݒ
+		if (head == cached_tail_)
+		{
+			cached_tail_ = tail_.load(std::memory_order_acquire);
+			if (head == cached_tail_)
+				return false;
+		}
+
+		*value = items_[head & mask_];
+		head_.store(head + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	// try_once ܂ő҂
+	// try_once  mutex_ ܂܌ĂԂƂ邽߁AWake Ăł͂ȂȂ
+	template <typename Try>
+	void Wait(Try try_once)
+	{
+		for (int i=0; i<spin_count_; ++i)
+		{
+			if (try_once())
+				return;
+			CAS_QUEUE_PAUSE();
+		}
+
+		std::unique_lock<std::mutex> lock(mutex_);
+		sleepers_.fetch_add(1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		changed_.wait(lock, try_once);
+		sleepers_.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	// ʒui߂ɌĂсAĂ鑊肪΋N
+	// sleepers_ 𑝂₵Ăm߂ Wait ƁAʒui߂Ă sleepers_ ǂނ̏ɂAN˂Ȃ
+	void Wake()
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (!sleepers_.load(std::memory_order_relaxed))
+			return;
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		changed_.notify_all();
+	}
+
+	const int spin_count_;
+	const size_t mask_;
+	std::vector<T> items_;
+
+	// ƓǏoϐ́Aʂ̃LbVCɒu
+	alignas(64) std::atomic<size_t> head_; // Ǐoi߂
+	alignas(64) std::atomic<size_t> tail_; // i߂
+	alignas(64) size_t cached_head_; // Ōɓǂ head_
+	alignas(64) size_t cached_tail_; // ǏoŌɓǂ tail_
+	alignas(64) std::atomic<int> sleepers_;
+	std::mutex mutex_;
+	std::condition_variable changed_;
+};
@@ -0,0 +1,94 @@
+#include <math.h>
+
+#include <algorithm>
+
+#include "cas_stats.h"
+
+
+static const char *const kStageNames[kCasStages] = {"upload", "compute", "readback", "total"};
+
+// value 𐔂
+// kCasStatsSubBuckets ͂̂܂܁Aȏ͍ŏʃrbg̈ʒuƁẢ2rbg狁߂
+static int BucketIndex(uint64_t value)
+{
+	if (value < kCasStatsSubBuckets)
+		return static_cast<int>(value);
+
+	int exponent = 63;
+	while (!(value >> exponent))
+		--exponent;
+
+	int index = (exponent - 1) * kCasStatsSubBuckets + static_cast<int>((value >> (exponent - 2)) & (kCasStatsSubBuckets - 1));
+	return std::min(index, kCasStatsBuckets - 1);
+}
+
+//  index ɐő̒l
+static uint64_t BucketUpperBound(int index)
+{
+	if (index < kCasStatsSubBuckets)
+		return static_cast<uint64_t>(index);
+
+	int exponent = index / kCasStatsSubBuckets + 1;
+	uint64_t step = uint64_t(1) << (exponent - 2);
+	uint64_t lower = static_cast<uint64_t>(kCasStatsSubBuckets + index % kCasStatsSubBuckets) * step;
+
+	return lower + step - 1;
+}
+
+const char *CasStageName(int stage)
+{
+	return 0 <= stage && stage < kCasStages ? kStageNames[stage] : "unknown";
+}
+
+void CasStatsReset(CasStageStats *stats)
+{
+	stats->count_.store(0, std::memory_order_relaxed);
+	stats->sum_.store(0, std::memory_order_relaxed);
+	stats->min_.store(UINT64_MAX, std::memory_order_relaxed);
+	stats->max_.store(0, std::memory_order_relaxed);
+	for (std::atomic<uint64_t> &bucket : stats->buckets_)
+		bucket.store(0, std::memory_order_relaxed);
+}
+
+void CasStatsRecord(CasStageStats *stats, uint64_t value)
+{
+	// ǂޑ͊elʂɓǂނ߁Al̊Ԃ͕̏ۏ؂Ȃ
+	stats->count_.fetch_add(1, std::memory_order_relaxed);
+	stats->sum_.fetch_add(value, std::memory_order_relaxed);
+	stats->buckets_[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+
+	// Xbh͒ʏ1ł邽߁Ar͂ق1ōς
+	uint64_t min = stats->min_.load(std::memory_order_relaxed);
+	while (value < min && !stats->min_.compare_exchange_weak(min, value, std::memory_order_relaxed))
+		;
+
+	uint64_t max = stats->max_.load(std::memory_order_relaxed);
+	while (max < value && !stats->max_.compare_exchange_weak(max, value, std::memory_order_relaxed))
+		;
+}
+
+uint64_t CasStatsPercentile(const CasStageStats *stats, double fraction)
+{
+	// ԂƂ̐ǂފԂɂL^iނ߁Av count_ ł͂ȂԂ狁߂
+	uint64_t counts[kCasStatsBuckets];
+	uint64_t total = 0;
+	for (int i=0; i<kCasStatsBuckets; ++i)
+	{
+		counts[i] = stats->buckets_[i].load(std::memory_order_relaxed);
+		total += counts[i];
+	}
+
+	if (!total)
+		return 0;
+
+	uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(ceil(std::clamp(fraction, 0.0, 1.0) * static_cast<double>(total))));
+	uint64_t seen = 0;
+	for (int i=0; i<kCasStatsBuckets; ++i)
+	{
+		seen += counts[i];
+		if (rank <= seen)
+			return std::min(BucketUpperBound(i), stats->max_.load(std::memory_order_relaxed));
+	}
+
+	return stats->max_.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+
+
+// Ԃ𐔂iK
+enum CasStage
+{
+	kCasStageUpload = 0, // sN`GPŨeNX`ɓ]
+	kCasStageCompute, // CASKp
+	kCasStageReadback, // ʂGPUǂݖ߂
+	kCasStageTotal, // Filter ̌ďoS
+	kCasStages
+};
+
+// Ԃ̕z𐔂Ԃ̐
+// 2ׂ̂悲Ƃ͈̔͂ kCasStatsSubBuckets ɓAΌ덷25%ȓ12^33܂ł𐔂
+static const int kCasStatsSubBuckets = 4;
+static const int kCasStatsBuckets = 128;
+
+// 1̒iK̏Ԃ̓v
+// bN炸ɍXVÃXbhȊOłǂ߂
+// el̒Pʂ͌ďo߂
+struct CasStageStats
+{
+	std::atomic<uint64_t> count_;
+	std::atomic<uint64_t> sum_;
+	std::atomic<uint64_t> min_; // L^ꍇ UINT64_MAX
+	std::atomic<uint64_t> max_;
+	std::atomic<uint64_t> buckets_[kCasStatsBuckets];
+};
+
+// iK̖OAVLC̕ϐȂǂɗp
+const char *CasStageName(int stage);
+
+void CasStatsReset(CasStageStats *stats);
+void CasStatsRecord(CasStageStats *stats, uint64_t value);
+
+// L^l̂A fraction (01) ̊ɂl
+// Ԃ̏[Ԃ߁A덷͋Ԃ̕܂łAL^ꍇ0
+uint64_t CasStatsPercentile(const CasStageStats *stats, double fraction);
@@ -0,0 +1,226 @@
+#include <inttypes.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "cas_trace.h"
+
+
+// XbhƂɕێCxgAtɂȂƋL^Xbht@Cɏ
+static const uint64_t kTraceThreadEvents = 8192;
+
+struct CasTraceEvent
+{
+	const char *name;
+	const char *category;
+	uint64_t begin;
+	uint64_t duration;
+	int64_t arg;
+};
+
+// XbhƂ̃Cxg̏zobt@
+// ̂͏LXbĥ݁Aǂނ̂ g_trace.mutex Xbĥ
+// CasTraceEnabled m߂ɋL^Ă悤Aobt@̓vZX̏I܂ŉȂ
+struct CasTraceBuffer
+{
+	int tid;
+	std::atomic<bool> owned; // LXbhĂAIXbh̃obt@͑̃Xbhg
+	std::atomic<uint64_t> committed; // L^Cxg
+	std::atomic<uint64_t> flushed; // t@CɏÂĂCxg
+	CasTraceEvent events[kTraceThreadEvents];
+};
+
+struct CasTraceState
+{
+	std::mutex mutex; // ȉׂ̂Ă
+	FILE *file;
+	int references;
+	unsigned long pid;
+	int next_tid;
+	std::vector<std::unique_ptr<CasTraceBuffer>> buffers;
+};
+
+// Xbh̏IɃobt@
+struct CasTraceOwner
+{
+	CasTraceBuffer *buffer = nullptr;
+
+	~CasTraceOwner()
+	{
+		if (buffer)
+			buffer->owned.store(false, std::memory_order_release);
+	}
+};
+
+static CasTraceState g_trace;
+static std::atomic<bool> g_trace_enabled(false);
+
+static thread_local CasTraceOwner t_trace_owner;
+
+
+// L^ς݂ł܂ĂȂCxgAg_trace.mutex ČĂ
+// t@CĂꍇ͎̂Ă
+static void FlushBuffer(CasTraceBuffer *buffer);
+
+// ďõXbh̃obt@A߂ċL^ꍇ͏IXbh̃obt@g񂷂AVɓo^
+static CasTraceBuffer *ThreadBuffer()
+{
+	if (t_trace_owner.buffer)
+		return t_trace_owner.buffer;
+
+	std::lock_guard<std::mutex> lock(g_trace.mutex);
+	if (!g_trace.file)
+		return nullptr;
+
+	CasTraceBuffer *buffer = nullptr;
+	for (std::unique_ptr<CasTraceBuffer> &candidate : g_trace.buffers)
+	{
+		if (!candidate->owned.load(std::memory_order_acquire))
+		{
+			buffer = candidate.get();
+			FlushBuffer(buffer);
+			break;
+		}
+	}
+
+	if (!buffer)
+	{
+		buffer = new(std::nothrow) CasTraceBuffer;
+		if (!buffer)
+			return nullptr;
+
+		buffer->committed.store(0, std::memory_order_relaxed);
+		buffer->flushed.store(0, std::memory_order_relaxed);
+		try
+		{
+			g_trace.buffers.emplace_back(buffer);
+		}
+		catch (...)
+		{
+			delete buffer;
+			return nullptr;
+		}
+	}
+
+	// g񂷏ꍇAʂ̃XbhƂĕ\悤ԍ߂
+	buffer->tid = ++g_trace.next_tid;
+	buffer->owned.store(true, std::memory_order_relaxed);
+	t_trace_owner.buffer = buffer;
+
+	return buffer;
+}
+
+static void FlushBuffer(CasTraceBuffer *buffer)
+{
+	uint64_t committed = buffer->committed.load(std::memory_order_acquire);
+	uint64_t flushed = buffer->flushed.load(std::memory_order_relaxed);
+
+	for (; g_trace.file && flushed<committed; ++flushed)
+	{
+		const CasTraceEvent &event = buffer->events[flushed % kTraceThreadEvents];
+		fprintf(g_trace.file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%" PRIu64 ",\"dur\":%" PRIu64 ",\"pid\":%lu,\"tid\":%d,\"args\":{\"n\":%" PRId64 "}}",
+			event.name, event.category, event.begin, event.duration, g_trace.pid, buffer->tid, event.arg);
+	}
+
+	buffer->flushed.store(committed, std::memory_order_release);
+}
+
+bool CasTraceOpen(const char *path)
+{
+	std::lock_guard<std::mutex> lock(g_trace.mutex);
+
+	if (g_trace.references)
+	{
+		++g_trace.references;
+		return true;
+	}
+
+	g_trace.file = fopen(path, "w");
+	if (!g_trace.file)
+		return false;
+
+#ifdef _WIN32
+	g_trace.pid = GetCurrentProcessId();
+#else
+	g_trace.pid = static_cast<unsigned long>(getpid());
+#endif
+
+	// ȍ~̃Cxg͏ ",\n" ŋ؂ď悤A擪ɃvZXu
+	fprintf(g_trace.file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%lu,\"tid\":0,\"args\":{\"name\":\"cas\"}}", g_trace.pid);
+
+	// ŐL^ɏꂽCxǵÃt@CɊ܂߂Ȃ
+	for (std::unique_ptr<CasTraceBuffer> &buffer : g_trace.buffers)
+		buffer->flushed.store(buffer->committed.load(std::memory_order_acquire), std::memory_order_release);
+
+	g_trace.references = 1;
+	g_trace_enabled.store(true, std::memory_order_release);
+
+	return true;
+}
+
+void CasTraceClose()
+{
+	std::lock_guard<std::mutex> lock(g_trace.mutex);
+
+	if (!g_trace.references || --g_trace.references)
+		return;
+
+	g_trace_enabled.store(false, std::memory_order_release);
+
+	for (std::unique_ptr<CasTraceBuffer> &buffer : g_trace.buffers)
+		FlushBuffer(buffer.get());
+
+	fprintf(g_trace.file, "\n]}\n");
+	fclose(g_trace.file);
+	g_trace.file = nullptr;
+}
+
+bool CasTraceEnabled()
+{
+	return g_trace_enabled.load(std::memory_order_relaxed);
+}
+
+uint64_t CasTraceNow()
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void CasTraceSpan(const char *name, const char *category, uint64_t begin, uint64_t end, int64_t arg)
+{
+	if (!CasTraceEnabled())
+		return;
+
+	CasTraceBuffer *buffer = ThreadBuffer();
+	if (!buffer)
+		return;
+
+	// t̏ꍇ̂݁AbNĎg̃obt@o
+	uint64_t committed = buffer->committed.load(std::memory_order_relaxed);
+	if (kTraceThreadEvents <= committed - buffer->flushed.load(std::memory_order_acquire))
+	{
+		std::lock_guard<std::mutex> lock(g_trace.mutex);
+		if (!g_trace.file)
+			return;
+		FlushBuffer(buffer);
+	}
+
+	CasTraceEvent &event = buffer->events[committed % kTraceThreadEvents];
+	event.name = name;
+	event.category = category;
+	event.begin = begin;
+	event.duration = end < begin ? 0 : end - begin;
+	event.arg = arg;
+
+	buffer->committed.store(committed + 1, std::memory_order_release);
+}
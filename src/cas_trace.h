@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdint.h>
+
+
+// Chrome  trace event ` (chrome://tracing  Perfetto ŊJ JSON) ŏ̋ԂL^
+// L^̓XbhƂ̃obt@ɃbN炸ɒǉAobt@tɂȂ CasTraceClose Ńt@Cɏ
+// L^ĂȂԂׂ́̕ACasTraceEnabled 1̓Ǎ̂
+
+// path ɋL^Jn
+// vZX1̃t@CɋL^AɊJnĂꍇ path 𖳎ĎQƂ𐔂݂̂Ƃ
+bool CasTraceOpen(const char *path);
+
+// CasTraceOpen Ɠ񐔌ĂԂƁAc̋L^ăt@C
+// ɋL^ꂽԂ͎̂ĂAXbhƂ̃obt@̓vZX̏I܂ŕێ
+void CasTraceClose();
+
+bool CasTraceEnabled();
+
+// L^ɗp鎞 (}CNb)
+uint64_t CasTraceNow();
+
+// begin  end ܂ł̋ԂAďõXbh̋ԂƂċL^
+// name  category ̓vO̕萔ƂAJSON̕ƂĂ̂܂܏ '"'  '\' ܂܂Ȃ
+// arg ̓t[ԍт̔ԍȂǁAԂʂl
+void CasTraceSpan(const char *name, const char *category, uint64_t begin, uint64_t end, int64_t arg);
@@ -0,0 +1,1264 @@
+// CPUłCAS̏x𑪂x`}[N
+// Ŏw肵x`}[NɎsAʂWo͂ɕ\
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define CAS_BENCH_HAVE_TSC 1
+#endif
+
+#include "cas_api.h"
+#include "cas_arena.h"
+#include "cas_cpu.h"
+#include "cas_numa.h"
+#include "cas_perf.h"
+#include "cas_pipeline.h"
+#include "cas_queue.h"
+#include "cas_stats.h"
+
+
+struct BenchOptions
+{
+	int threads;
+	int width;
+	int height;
+	int count;
+	int iterations;
+	int quality;
+	float sharpness;
+	bool perf; // \JE^\
+};
+
+// vɗpBGRẢ摜
+struct BenchImage
+{
+	std::vector<uint8_t> pixels;
+	CasCpuImage image;
+};
+
+typedef void (*BenchFunction)(const BenchOptions &options);
+
+struct Bench
+{
+	const char *name;
+	const char *description;
+	BenchFunction function;
+};
+
+// q[v̊mۉ
+// operator new uĐAJԂĂq[vmۂȂƂm߂
+static std::atomic<uint64_t> g_allocations(0);
+
+// mFsx`}[NsAIR[h EXIT_FAILURE ɂ CTest Ōoł悤ɂ
+static bool g_failed = false;
+
+
+void *operator new(size_t size)
+{
+	++g_allocations;
+	void *p = malloc(size ? size : 1);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void *p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+	free(p);
+}
+
+static double Now()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ^CX^vJE^Ax86ȊOł0
+static uint64_t Ticks()
+{
+#if CAS_BENCH_HAVE_TSC
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+// JԂ񐔂w肳ĂȂꍇ́Ax`}[NƂ̊̉񐔂p
+static int Iterations(const BenchOptions &options, int default_iterations)
+{
+	return options.iterations ? options.iterations : default_iterations;
+}
+
+// 摜̑傫w肳ĂȂꍇ́Ax`}[NƂ̊̑傫p
+static void ImageSize(const BenchOptions &options, int default_width, int default_height, int *width, int *height)
+{
+	*width = options.width ? options.width : default_width;
+	*height = options.height ? options.height : default_height;
+}
+
+// --perf w肵ꍇ̂ݐ\JE^JAJȂꍇ͋U
+// XbhOɌĂсA[J[悤ɂ
+static bool OpenPerf(const BenchOptions &options, PerfCounters *counters)
+{
+	if (!options.perf)
+		return false;
+
+	if (PerfOpen(counters))
+		return true;
+
+	fprintf(stderr, "cas_bench: performance counters are not available (see /proc/sys/kernel/perf_event_paranoid)\n");
+	return false;
+}
+
+// \JE^̌oƁAvԂ̒l
+// bytes ͋Ԃœǂݏ摜̃oCgŁA1TCNɓǂݏoCg߂
+static void PrintPerfHeader()
+{
+	printf(" %6s %8s %9s %9s %9s", "IPC", "B/cycle", "L1D/px", "LLC/px", "dTLB/px");
+}
+
+static void PrintPerf(const PerfSample &sample, double pixels, double bytes)
+{
+	double cycles = sample.values[kPerfCycles];
+	bool has_cycles = sample.valid[kPerfCycles] && 0.0 < cycles;
+
+	if (has_cycles && sample.valid[kPerfInstructions])
+		printf(" %6.2f", sample.values[kPerfInstructions] / cycles);
+	else
+		printf(" %6s", "n/a");
+
+	if (has_cycles)
+		printf(" %8.2f", bytes / cycles);
+	else
+		printf(" %8s", "n/a");
+
+	for (int counter : {kPerfL1dMisses, kPerfLlcMisses, kPerfDtlbMisses})
+	{
+		if (sample.valid[counter])
+			printf(" %9.4f", sample.values[counter] / pixels);
+		else
+			printf(" %9s", "n/a");
+	}
+}
+
+static void MakeImage(int width, int height, uint32_t seed, BenchImage *image)
+{
+	std::mt19937 random(seed);
+
+	image->pixels.resize(static_cast<size_t>(width) * height * 4);
+	for (uint8_t &pixel : image->pixels)
+		pixel = static_cast<uint8_t>(random());
+
+	image->image.pixels = image->pixels.data();
+	image->image.pitch = static_cast<ptrdiff_t>(width) * 4;
+	image->image.width = width;
+	image->image.height = height;
+}
+
+// ȉ摜𑽐ꍇ́A1Ƃ̌ďoƈꊇ̔r
+// UCN}`r[Â悤ɁA1t[1664̏ȉfׂprz肷
+static void BenchBatch(const BenchOptions &options)
+{
+	std::vector<BenchImage> src(options.count);
+	std::vector<BenchImage> dst(options.count);
+	std::vector<CasCpuBatchItem> items(options.count);
+	int width;
+	int height;
+
+	int iterations = Iterations(options, 100);
+
+	ImageSize(options, 480, 270, &width, &height);
+	for (int i=0; i<options.count; ++i)
+	{
+		MakeImage(width, height, i, &src[i]);
+		MakeImage(width, height, i, &dst[i]);
+		items[i].src = src[i].image;
+		items[i].dst = dst[i].image;
+		items[i].sharpness = options.sharpness;
+	}
+
+	CasCpuEngine *engine = CasCpuCreate(options.threads);
+	if (!engine)
+	{
+		fprintf(stderr, "cas_bench: cannot create CAS engine\n");
+		return;
+	}
+
+	// 1ڂ̓y[W̊Ȃǂ܂ނ߁AvȂ
+	CasCpuFilterBatch(engine, items.data(), options.count, options.quality);
+
+	double start = Now();
+	for (int n=0; n<iterations; ++n)
+	{
+		for (const CasCpuBatchItem &item : items)
+			CasCpuFilter(engine, &item.src, &item.dst, item.sharpness, options.quality);
+	}
+	double single = Now() - start;
+
+	start = Now();
+	for (int n=0; n<iterations; ++n)
+		CasCpuFilterBatch(engine, items.data(), options.count, options.quality);
+	double batch = Now() - start;
+
+	CasCpuDestroy(engine);
+
+	double images = static_cast<double>(iterations) * options.count;
+	double single_us = single / images * 1e6;
+	double batch_us = batch / images * 1e6;
+
+	printf("batch: %d images %dx%d, %d iterations\n", options.count, width, height, iterations);
+	printf("  single  %9.2f us/image\n", single_us);
+	printf("  batch   %9.2f us/image\n", batch_us);
+	printf("  saved   %9.2f us/image per-call overhead (%.2fx)\n", single_us - batch_us, single / batch);
+}
+
+// ͂𒼐ړǂݏo͂ɒڏƁAGPȔƓƗp̉摜oR鏈̔r
+// Ɨp̉摜oRꍇ́A͂̃Rs[ACASAo͂ւ̃Rs[3iKɂȂ
+static void BenchFused(const BenchOptions &options)
+{
+	int width;
+	int height;
+	BenchImage src;
+	BenchImage dst;
+	BenchImage upload;
+	BenchImage download;
+
+	int iterations = Iterations(options, 20);
+
+	ImageSize(options, 1920, 1080, &width, &height);
+	MakeImage(width, height, 1, &src);
+	MakeImage(width, height, 2, &dst);
+	MakeImage(width, height, 3, &upload);
+	MakeImage(width, height, 4, &download);
+
+	CasCpuEngine *engine = CasCpuCreate(options.threads);
+	if (!engine)
+	{
+		fprintf(stderr, "cas_bench: cannot create CAS engine\n");
+		return;
+	}
+
+	CasCpuFilter(engine, &src.image, &dst.image, options.sharpness, options.quality);
+
+	double start = Now();
+	for (int n=0; n<iterations; ++n)
+		CasCpuFilter(engine, &src.image, &dst.image, options.sharpness, options.quality);
+	double fused = Now() - start;
+
+	start = Now();
+	for (int n=0; n<iterations; ++n)
+	{
+		memcpy(upload.pixels.data(), src.pixels.data(), src.pixels.size());
+		CasCpuFilter(engine, &upload.image, &download.image, options.sharpness, options.quality);
+		memcpy(dst.pixels.data(), download.pixels.data(), dst.pixels.size());
+	}
+	double staged = Now() - start;
+
+	CasCpuDestroy(engine);
+
+	double frame_bytes = static_cast<double>(src.pixels.size());
+	printf("fused: %dx%d, %d iterations\n", width, height, iterations);
+	printf("  fused   %9.3f ms/frame, %8.1f MiB/s of input\n", fused / iterations * 1e3, frame_bytes * iterations / fused / (1 << 20));
+	printf("  staged  %9.3f ms/frame, %8.1f MiB/s of input (%.2fx)\n", staged / iterations * 1e3, frame_bytes * iterations / staged / (1 << 20), staged / fused);
+}
+
+// 1080p8K܂ł̉f̏ԂAc̒ZɕꍇƕȂꍇŔׂ
+// Zɕꍇ́ALȂĂf̏ԂقڕςȂƂm߂
+static void BenchStrips(const BenchOptions &options)
+{
+	static const int kSizes[][2] = {{1920, 1080}, {2560, 1440}, {3840, 2160}, {7680, 4320}};
+
+	CasCpuEngine *engine = CasCpuCreate(options.threads);
+	if (!engine)
+	{
+		fprintf(stderr, "cas_bench: cannot create CAS engine\n");
+		return;
+	}
+
+	size_t strip_bytes = CasCpuStripBytes(engine);
+	int iterations = Iterations(options, 3);
+
+	printf("strips: strip %zu bytes, %d iterations\n", strip_bytes, iterations);
+	printf("  %-10s %14s %14s %14s %14s\n", "size", "strip ns/px", "strip cyc/px", "full ns/px", "full cyc/px");
+
+	for (const int (&size)[2] : kSizes)
+	{
+		BenchImage src;
+		BenchImage dst;
+		double seconds[2];
+		double cycles[2];
+
+		MakeImage(size[0], size[1], 1, &src);
+		MakeImage(size[0], size[1], 2, &dst);
+
+		for (int mode=0; mode<2; ++mode)
+		{
+			CasCpuSetStripBytes(engine, 0 == mode ? strip_bytes : 0);
+			CasCpuFilter(engine, &src.image, &dst.image, options.sharpness, options.quality);
+
+			double start = Now();
+			uint64_t ticks = Ticks();
+			for (int n=0; n<iterations; ++n)
+				CasCpuFilter(engine, &src.image, &dst.image, options.sharpness, options.quality);
+			cycles[mode] = static_cast<double>(Ticks() - ticks);
+			seconds[mode] = Now() - start;
+		}
+
+		double pixels = static_cast<double>(size[0]) * size[1] * iterations;
+		char name[32];
+		snprintf(name, sizeof (name), "%dx%d", size[0], size[1]);
+		printf("  %-10s %14.3f %14.2f %14.3f %14.2f\n", name, seconds[0] / pixels * 1e9, cycles[0] / pixels, seconds[1] / pixels * 1e9, cycles[1] / pixels);
+	}
+
+	CasCpuDestroy(engine);
+}
+
+// ȃt[̘AA1тɕďꍇƁÃt[𓯎ɏꍇŔׂ
+// ɏt[̓XbhƓƂAet[1Xbhŏ
+static void BenchFrames(const BenchOptions &options)
+{
+	int width;
+	int height;
+	int threads = options.threads ? options.threads : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	int frames = std::max(2, threads);
+	std::vector<BenchImage> src(options.count);
+	std::vector<BenchImage> dst(options.count);
+
+	int iterations = Iterations(options, 10);
+
+	ImageSize(options, 480, 270, &width, &height);
+	for (int i=0; i<options.count; ++i)
+	{
+		MakeImage(width, height, i, &src[i]);
+		MakeImage(width, height, i, &dst[i]);
+	}
+
+	CasCpuEngine *engine = CasCpuCreate(threads);
+	CasCpuPipeline *pipeline = CasCpuPipelineCreate(frames, frames);
+	if (!engine || !pipeline)
+	{
+		fprintf(stderr, "cas_bench: cannot create CAS engine\n");
+		CasCpuDestroy(engine);
+		CasCpuPipelineDestroy(pipeline);
+		return;
+	}
+
+	CasCpuFilter(engine, &src[0].image, &dst[0].image, options.sharpness, options.quality);
+
+	double start = Now();
+	for (int n=0; n<iterations; ++n)
+	{
+		for (int i=0; i<options.count; ++i)
+			CasCpuFilter(engine, &src[i].image, &dst[i].image, options.sharpness, options.quality);
+	}
+	double tiles = Now() - start;
+
+	// 󂫂ȂłÂt[󂯎AtB^ Filter Ɠg
+	// 󂯎t[ł邱Ƃm߂
+	bool ordered = true;
+	long long submitted = 0;
+	long long received = 0;
+	void *user_data;
+
+	start = Now();
+	for (int n=0; n<iterations; ++n)
+	{
+		for (int i=0; i<options.count; ++i)
+		{
+			if (frames <= CasCpuPipelinePending(pipeline) && CasCpuPipelineReceive(pipeline, true, &user_data, nullptr))
+				ordered &= reinterpret_cast<intptr_t>(user_data) == received++;
+
+			CasCpuPipelineSubmit(pipeline, &src[i].image, &dst[i].image, options.sharpness, options.quality, reinterpret_cast<void *>(static_cast<intptr_t>(submitted++)));
+		}
+	}
+	while (CasCpuPipelineReceive(pipeline, true, &user_data, nullptr))
+		ordered &= reinterpret_cast<intptr_t>(user_data) == received++;
+	double pipelined = Now() - start;
+
+	CasCpuPipelineDestroy(pipeline);
+	CasCpuDestroy(engine);
+
+	double count = static_cast<double>(iterations) * options.count;
+	printf("frames: %d frames %dx%d, %d threads, %d in flight, %d iterations\n", options.count, width, height, threads, frames, iterations);
+	printf("  tiles    %9.3f ms/frame\n", tiles / count * 1e3);
+	printf("  frames   %9.3f ms/frame (%.2fx)%s\n", pipelined / count * 1e3, tiles / pipelined, ordered ? "" : " OUT OF ORDER");
+}
+
+// rɗpAmutex Əϐɂ̂L[
+template <typename T>
+class MutexQueue
+{
+public:
+	explicit MutexQueue(size_t capacity)
+		: capacity_(capacity)
+	{
+	}
+
+	void Push(T value)
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		not_full_.wait(lock, [&]{return items_.size() < capacity_;});
+		items_.push_back(value);
+		not_empty_.notify_one();
+	}
+
+	T Pop()
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		not_empty_.wait(lock, [&]{return !items_.empty();});
+		T value = items_.front();
+		items_.pop_front();
+		not_full_.notify_one();
+		return value;
+	}
+
+private:
+	size_t capacity_;
+	std::deque<T> items_;
+	std::mutex mutex_;
+	std::condition_variable not_empty_;
+	std::condition_variable not_full_;
+};
+
+// 1󂯓nA󂯎܂ł̎Ԃ𑪂
+// 󂯎ԎԂ܂Ŏ𑗂Ȃ߁A񑊎肪҂ĂԂ̎nɂȂ
+template <typename Queue>
+static void MeasureHandOff(int count, std::vector<double> *latencies)
+{
+	Queue requests(4);
+	Queue replies(4);
+
+	latencies->resize(count);
+
+	std::thread consumer([&]
+	{
+		for (int i=0; i<count; ++i)
+		{
+			double sent = requests.Pop();
+			(*latencies)[i] = Now() - sent;
+			replies.Push(0.0);
+		}
+	});
+
+	for (int i=0; i<count; ++i)
+	{
+		requests.Push(Now());
+		replies.Pop();
+	}
+
+	consumer.join();
+
+	std::sort(latencies->begin(), latencies->end());
+}
+
+// t[̎nɗpL[́A1̎nɂ鎞
+static void BenchQueue(const BenchOptions &options)
+{
+	int count = Iterations(options, 20000);
+	std::vector<double> latencies[2];
+
+	MeasureHandOff<MutexQueue<double>>(count, &latencies[0]);
+	MeasureHandOff<SpscQueue<double>>(count, &latencies[1]);
+
+	static const char *const kNames[] = {"mutex", "spsc"};
+	printf("queue: %d hand-offs\n", count);
+	printf("  %-8s %10s %10s %10s %10s\n", "", "p50 us", "p90 us", "p99 us", "max us");
+	for (int i=0; i<2; ++i)
+	{
+		const std::vector<double> &l = latencies[i];
+		printf("  %-8s %10.2f %10.2f %10.2f %10.2f\n", kNames[i], l[count / 2] * 1e6, l[count * 9 / 10] * 1e6, l[count * 99 / 100] * 1e6, l.back() * 1e6);
+	}
+}
+
+// Ɨ̈OɓnꍇɁAJԂĂq[vmۂȂƂm߂
+// tB^ Open ƓAƗ̈1 CasArena ؂oēn
+// frame  Filter CPUł̏ƓACASɉĒiKƂ̏Ԃ
+// api  cas_context_reserve ̌ BGRA ƕʂ݂ cas_process ŏAƗ̈͐Ȃ - ƕ\
+// cas_process \傫ȉ摜 CAS_ERROR_NOT_RESERVED ԂAƗ̈LȂƂm߂
+// q[vƗ̈mۂꍇƁAɎsꍇ g_failed 𗧂Ă
+static void BenchAlloc(const BenchOptions &options)
+{
+	int width;
+	int height;
+	BenchImage src;
+	BenchImage dst;
+
+	int iterations = Iterations(options, 10);
+
+	ImageSize(options, 1920, 1080, &width, &height);
+	MakeImage(width, height, 1, &src);
+	MakeImage(width, height, 2, &dst);
+
+	CasCpuEngine *engine = CasCpuCreate(options.threads);
+	CasCpuPipeline *pipeline = CasCpuPipelineCreate(2, options.threads);
+	CasArena arena;
+	size_t engine_size = engine ? CasArenaPitch(CasCpuScratchSize(engine, 4, width, height)) : 0;
+	size_t pipeline_size = pipeline ? CasCpuPipelineScratchSize(pipeline, width, height) : 0;
+	if (!engine || !pipeline || !CasArenaCreate(&arena, engine_size + pipeline_size, true))
+	{
+		fprintf(stderr, "cas_bench: cannot create CAS engine\n");
+		CasCpuDestroy(engine);
+		CasCpuPipelineDestroy(pipeline);
+		g_failed = true;
+		return;
+	}
+
+	CasCpuSetScratch(engine, CasArenaAlloc(&arena, engine_size), engine_size);
+	CasCpuPipelineSetScratch(pipeline, CasArenaAlloc(&arena, pipeline_size), pipeline_size);
+
+	// \͔̕n߁AŜ̉摜fĂŜ̑傫ŗ\񂵒
+	cas_image_view api_src = {src.image.pixels, src.image.pitch, width, height};
+	cas_image api_dst = {dst.image.pixels, dst.image.pitch, width, height};
+	cas_image_view api_plane_src = {src.image.pixels, src.image.pitch, width * 4, height};
+	cas_image api_plane_dst = {dst.image.pixels, dst.image.pitch, width * 4, height};
+	cas_context *context = cas_context_create(options.threads);
+	bool reserved = context && CAS_OK == cas_context_reserve(context, CAS_FORMAT_BGRA8, (width + 1) / 2, height);
+	bool refused = reserved && 1 < width && CAS_ERROR_NOT_RESERVED == cas_process(context, CAS_FORMAT_BGRA8, &api_src, &api_dst, options.sharpness, static_cast<cas_quality>(options.quality));
+	reserved = reserved && CAS_OK == cas_context_reserve(context, CAS_FORMAT_BGRA8, width, height) && CAS_OK == cas_context_reserve(context, CAS_FORMAT_PLANE8, width * 4, height);
+	if (!reserved || (1 < width && !refused))
+	{
+		fprintf(stderr, "cas_bench: cas_context_reserve did not bound cas_process\n");
+		g_failed = true;
+	}
+
+	printf("alloc: %dx%d, scratch %zu bytes, %d iterations\n", width, height, arena.size_, iterations);
+	printf("  %-10s %12s %12s\n", "", "heap", "scratch");
+
+	CasStageStats stats[kCasStages];
+	for (CasStageStats &stage : stats)
+		CasStatsReset(&stage);
+
+	for (int mode=0; mode<5; ++mode)
+	{
+		static const char *const kNames[] = {"filter", "in-place", "pipeline", "frame", "api"};
+		if (4 == mode && !reserved)
+			break;
+
+		uint64_t heap = 0;
+		bool filtered = true;
+		uint64_t scratch = CasCpuScratchAllocations(engine) + CasCpuPipelineScratchAllocations(pipeline);
+
+		// 1ڂ̓[J[̋NȂǂ܂ނ߁AȂ
+		for (int n=0; n<=iterations; ++n)
+		{
+			uint64_t before = g_allocations;
+			void *user_data;
+
+			if (0 == mode)
+			{
+				filtered &= CasCpuFilter(engine, &src.image, &dst.image, options.sharpness, options.quality);
+			}
+			else if (1 == mode)
+			{
+				filtered &= CasCpuFilterInPlace(engine, &dst.image, options.sharpness, options.quality);
+			}
+			else if (2 == mode)
+			{
+				bool frame_filtered = false;
+				CasCpuPipelineSubmit(pipeline, &src.image, &dst.image, options.sharpness, options.quality, nullptr);
+				CasCpuPipelineReceive(pipeline, true, &user_data, &frame_filtered);
+				filtered &= frame_filtered;
+			}
+			else if (4 == mode)
+			{
+				if (n & 1)
+					filtered &= CAS_OK == cas_process(context, CAS_FORMAT_PLANE8, &api_plane_src, &api_plane_dst, options.sharpness, static_cast<cas_quality>(options.quality));
+				else
+					filtered &= CAS_OK == cas_process(context, CAS_FORMAT_BGRA8, &api_src, &api_dst, options.sharpness, static_cast<cas_quality>(options.quality));
+			}
+			else
+			{
+				double start = Now();
+				filtered &= CasCpuFilter(engine, &src.image, &dst.image, options.sharpness, options.quality);
+				uint64_t elapsed = static_cast<uint64_t>((Now() - start) * 1e6);
+				CasStatsRecord(&stats[kCasStageCompute], elapsed);
+				CasStatsRecord(&stats[kCasStageTotal], elapsed);
+			}
+
+			if (n)
+				heap += g_allocations - before;
+		}
+
+		scratch = CasCpuScratchAllocations(engine) + CasCpuPipelineScratchAllocations(pipeline) - scratch;
+		bool failed = heap || scratch || !filtered;
+		if (4 == mode)
+			printf("  %-10s %12llu %12s%s\n", kNames[mode], static_cast<unsigned long long>(heap), "-", failed ? " FAIL" : "");
+		else
+			printf("  %-10s %12llu %12llu%s\n", kNames[mode], static_cast<unsigned long long>(heap), static_cast<unsigned long long>(scratch), failed ? " FAIL" : "");
+		g_failed |= failed;
+	}
+
+	cas_context_destroy(context);
+	CasCpuPipelineDestroy(pipeline);
+	CasCpuDestroy(engine);
+	CasArenaDestroy(&arena);
+}
+
+// ߓIȃq[Wy[WƂĊ蓖Ăꂽ (KiB)A擾łȂꍇ-1
+static long AnonHugePagesKiB()
+{
+#ifdef __linux__
+	FILE *file = fopen("/proc/self/smaps_rollup", "r");
+	if (!file)
+		return -1;
+
+	char line[256];
+	long kib = -1;
+	while (fgets(line, sizeof (line), file))
+	{
+		if (1 == sscanf(line, "AnonHugePages: %ld kB", &kib))
+			break;
+	}
+	fclose(file);
+
+	return kib;
+#else
+	return -1;
+#endif
+}
+
+// 8K̃t[ʏ̃y[Wƃq[Wy[Wɒuꍇ̏Ԃ̔r
+// o͂̉摜 CasArena ŊmۂAhuge_pages ݂̂ς
+static void BenchHugePages(const BenchOptions &options)
+{
+	static const char *const kPageNames[] = {"small", "thp", "hugetlb"};
+	int width;
+	int height;
+
+	int iterations = Iterations(options, 3);
+
+	ImageSize(options, 7680, 4320, &width, &height);
+	size_t pitch = CasArenaPitch(static_cast<size_t>(width) * 4);
+	size_t size = pitch * height;
+
+	PerfCounters counters;
+	bool perf = OpenPerf(options, &counters);
+
+	CasCpuEngine *engine = CasCpuCreate(options.threads);
+	if (!engine)
+	{
+		fprintf(stderr, "cas_bench: cannot create CAS engine\n");
+		if (perf)
+			PerfClose(&counters);
+		return;
+	}
+
+	printf("hugepages: %dx%d, pitch %zu, %d iterations\n", width, height, pitch, iterations);
+	printf("  %-10s %-8s %12s %12s %14s", "request", "pages", "ms/frame", "ns/px", "AnonHuge MiB");
+	if (perf)
+		PrintPerfHeader();
+	printf("\n");
+
+	for (int mode=0; mode<2; ++mode)
+	{
+		bool huge_pages = 1 == mode;
+		CasArena arena;
+		if (!CasArenaCreate(&arena, size * 2, huge_pages))
+		{
+			fprintf(stderr, "cas_bench: cannot allocate %zu bytes\n", size * 2);
+			break;
+		}
+
+		CasCpuImage src;
+		src.pixels = static_cast<uint8_t *>(CasArenaAlloc(&arena, size));
+		src.pitch = static_cast<ptrdiff_t>(pitch);
+		src.width = width;
+		src.height = height;
+		CasCpuImage dst = src;
+		dst.pixels = static_cast<uint8_t *>(CasArenaAlloc(&arena, size));
+
+		std::mt19937 random(1);
+		for (size_t i=0; i<size; ++i)
+			src.pixels[i] = static_cast<uint8_t>(random());
+		memset(dst.pixels, 0, size);
+
+		CasCpuFilter(engine, &src, &dst, options.sharpness, options.quality);
+		long huge_kib = AnonHugePagesKiB();
+
+		PerfSample sample;
+		if (perf)
+			PerfStart(&counters);
+		double start = Now();
+		for (int n=0; n<iterations; ++n)
+			CasCpuFilter(engine, &src, &dst, options.sharpness, options.quality);
+		double seconds = Now() - start;
+		if (perf)
+			PerfStop(&counters, &sample);
+
+		double pixels = static_cast<double>(width) * height * iterations;
+		printf("  %-10s %-8s %12.3f %12.3f %14.1f", huge_pages ? "huge" : "small", kPageNames[arena.pages_], seconds / iterations * 1e3, seconds / pixels * 1e9, huge_kib < 0 ? -1.0 : huge_kib / 1024.0);
+		if (perf)
+			PrintPerf(sample, pixels, pixels * 8.0);
+		printf("\n");
+
+		CasArenaDestroy(&arena);
+	}
+
+	CasCpuDestroy(engine);
+	if (perf)
+		PerfClose(&counters);
+}
+
+// kernels  roofline ŌvJ[l
+enum BenchKernel
+{
+	kKernelBgra = 0,
+	kKernelPlane,
+	kKernelInPlace,
+	kKernels
+};
+
+static const char *const kKernelNames[kKernels] = {"bgra", "plane", "in-place"};
+static const int kKernelColors[kKernels] = {3, 1, 3};
+static const int kKernelBytes[kKernels] = {8, 2, 8}; // 1fɓǂݏoCg
+
+// J[lɓn摜
+// 1`l̉摜́ABGRẢ摜̐擪𕝂Ɠsb`ŗp
+struct KernelImages
+{
+	BenchImage src;
+	BenchImage dst;
+	CasCpuImage plane_src;
+	CasCpuImage plane_dst;
+};
+
+static void MakeKernelImages(int width, int height, KernelImages *images)
+{
+	MakeImage(width, height, 1, &images->src);
+	MakeImage(width, height, 2, &images->dst);
+	images->plane_src = images->src.image;
+	images->plane_src.pitch = width;
+	images->plane_dst = images->dst.image;
+	images->plane_dst.pitch = width;
+}
+
+static void RunKernel(CasCpuEngine *engine, const KernelImages &images, int kernel, float sharpness, int quality)
+{
+	if (kKernelBgra == kernel)
+		CasCpuFilter(engine, &images.src.image, &images.dst.image, sharpness, quality);
+	else if (kKernelPlane == kernel)
+		CasCpuFilterPlane(engine, &images.plane_src, &images.plane_dst, sharpness, quality);
+	else
+		CasCpuFilterInPlace(engine, &images.src.image, sharpness, quality);
+}
+
+// eCAS̃J[ĺA1t[̏Ԃ1b̉f
+// --perf w肵ꍇ́AIPCA1TCNɓǂݏ摜̃oCgA1f̃~X̉񐔂\
+static void BenchKernels(const BenchOptions &options)
+{
+	int width;
+	int height;
+	KernelImages images;
+
+	int iterations = Iterations(options, 10);
+
+	ImageSize(options, 1920, 1080, &width, &height);
+	MakeKernelImages(width, height, &images);
+
+	PerfCounters counters;
+	bool perf = OpenPerf(options, &counters);
+
+	CasCpuEngine *engine = CasCpuCreate(options.threads);
+	if (!engine)
+	{
+		fprintf(stderr, "cas_bench: cannot create CAS engine\n");
+		if (perf)
+			PerfClose(&counters);
+		return;
+	}
+
+	printf("kernels: %dx%d, %d iterations\n", width, height, iterations);
+	printf("  %-10s %-8s %10s %10s", "kernel", "quality", "ms/frame", "Mpx/s");
+	if (perf)
+		PrintPerfHeader();
+	printf("\n");
+
+	for (int kernel=0; kernel<kKernels; ++kernel)
+	{
+		for (int quality=0; quality<kCasQualityLevels; ++quality)
+		{
+			RunKernel(engine, images, kernel, options.sharpness, quality);
+
+			PerfSample sample;
+			if (perf)
+				PerfStart(&counters);
+			double start = Now();
+			for (int n=0; n<iterations; ++n)
+				RunKernel(engine, images, kernel, options.sharpness, quality);
+			double seconds = Now() - start;
+			if (perf)
+				PerfStop(&counters, &sample);
+
+			double pixels = static_cast<double>(width) * height * iterations;
+			printf("  %-10s %-8d %10.3f %10.1f", kKernelNames[kernel], quality, seconds / iterations * 1e3, pixels / seconds * 1e-6);
+			if (perf)
+				PrintPerf(sample, pixels, pixels * kKernelBytes[kernel]);
+			printf("\n");
+		}
+	}
+
+	CasCpuDestroy(engine);
+	if (perf)
+		PerfClose(&counters);
+}
+
+// J[l̓RpC̎xNgɗ邽߁Arh̖߃ZbgSIMD̒iKƂ
+// lanes 1߂ŏPx_̐
+static const char *SimdTier(int *lanes)
+{
+#if defined(__AVX512F__)
+	*lanes = 16;
+	return "avx512";
+#elif defined(__AVX2__) && defined(__FMA__)
+	*lanes = 8;
+	return "avx2+fma";
+#elif defined(__AVX__)
+	*lanes = 8;
+	return "avx";
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && 2 <= _M_IX86_FP)
+	*lanes = 4;
+	return "sse2";
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+	*lanes = 4;
+	return "neon";
+#else
+	*lanes = 1;
+	return "scalar";
+#endif
+}
+
+// STREAM ƓAeXbhz̘A͈͂󂯎
+// z͍ŏIx̃LbVɎ܂Ȃ傫Ƃ
+static const size_t kStreamBytes = static_cast<size_t>(256) << 20;
+
+enum StreamKernel
+{
+	kStreamRead = 0,
+	kStreamWrite,
+	kStreamCopy,
+	kStreamKernels
+};
+
+static const char *const kStreamNames[kStreamKernels] = {"read", "write", "copy"};
+
+// Ǎ̌ʂ̂ĂȂ߂̏o͐
+static std::atomic<uint64_t> g_stream_sink(0);
+
+static void StreamRange(int kernel, const uint8_t *src, uint8_t *dst, size_t begin, size_t end)
+{
+	if (kStreamRead == kernel)
+	{
+		// ̉Z̓RpCxNg邽߁AǍ݂̂ŗ
+		const uint64_t *p = reinterpret_cast<const uint64_t *>(src + begin);
+		size_t count = (end - begin) / sizeof (uint64_t);
+		uint64_t sum = 0;
+		for (size_t i=0; i<count; ++i)
+			sum += p[i];
+		g_stream_sink += sum;
+	}
+	else if (kStreamWrite == kernel)
+	{
+		memset(dst + begin, 0x5a, end - begin);
+	}
+	else
+	{
+		memcpy(dst + begin, src + begin, end - begin);
+	}
+}
+
+// threads ̃XbhŔzŜ1񏈗b
+static double MeasureStream(int kernel, const uint8_t *src, uint8_t *dst, int threads)
+{
+	std::vector<std::thread> workers;
+	size_t range = kStreamBytes / threads & ~static_cast<size_t>(kCasArenaAlignment - 1);
+
+	double start = Now();
+	for (int i=1; i<threads; ++i)
+		workers.emplace_back(StreamRange, kernel, src, dst, range * i, i + 1 == threads ? kStreamBytes : range * (i + 1));
+	StreamRange(kernel, src, dst, 0, 1 == threads ? kStreamBytes : range);
+	for (std::thread &worker : workers)
+		worker.join();
+
+	return Now() - start;
+}
+
+// ƗϘǎnAxNg̃WX^𖞂ׂ
+// n̒l 1 Ɏ邽߁A񐳋KɂɂȂȂ
+static const int kFlopChains = 32;
+static const int kFlopSteps = 1 << 20;
+
+static std::atomic<uint32_t> g_flop_sink(0);
+
+static void FlopRange()
+{
+	float x[kFlopChains];
+	for (int i=0; i<kFlopChains; ++i)
+		x[i] = static_cast<float>(i) / kFlopChains;
+
+	const float m = 0.999999f;
+	const float a = 0.000001f;
+	for (int step=0; step<kFlopSteps; ++step)
+	{
+		for (int i=0; i<kFlopChains; ++i)
+			x[i] = x[i] * m + a;
+	}
+
+	float sum = 0.0f;
+	for (float v : x)
+		sum += v;
+	g_flop_sink += static_cast<uint32_t>(sum);
+}
+
+// threads ̃XbhŁA1bɎsłPx_Z̐
+static double MeasureFlops(int threads)
+{
+	std::vector<std::thread> workers;
+
+	double start = Now();
+	for (int i=1; i<threads; ++i)
+		workers.emplace_back(FlopRange);
+	FlopRange();
+	for (std::thread &worker : workers)
+		worker.join();
+	double seconds = Now() - start;
+
+	return 2.0 * kFlopChains * kFlopSteps * threads / seconds;
+}
+
+// CasPlanarRow 1f̕_Z̊TZ
+// minAmaxAt (ߎ܂) ꂼ1ƐAsRGBƂ̕ϊ͕\ߐȂ
+static double KernelFlops(int colors, int quality)
+{
+	unsigned flags = CasQualityFlags(quality);
+	int weight_colors = (flags & kCasSlow) ? colors : 1;
+
+	// d: ŏlƍőlAlimit - mxAminAtAZAsaturate
+	int amp = (flags & kCasBetterDiagonals) ? 20 : 14;
+	// o: \4f̘aAϘaAZAsaturate ƁAsRGB̕\̓Y̐Ϙa
+	int value = 7 + 2;
+
+	return weight_colors * amp + colors * value;
+}
+
+// шƕ_Z̐\VƂAeJ[l̉f/bׂ
+// ш̓V copy ̑ш1fɓǂݏoCgŊ
+// Z̓V͕_Z̐\1f̉ZŊ
+// J[lш̓Vɋ߂ꍇAJ[l𑬂Ăʂ͖AFilter ł̃Rs[炷
+static void BenchRoofline(const BenchOptions &options)
+{
+	int width;
+	int height;
+	int lanes;
+	KernelImages images;
+
+	int iterations = Iterations(options, 10);
+	int threads = options.threads ? options.threads : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	const char *tier = SimdTier(&lanes);
+
+	// ш͊e̍ŗǒlp
+	std::vector<uint8_t> src(kStreamBytes, 1);
+	std::vector<uint8_t> dst(kStreamBytes, 2);
+	double bandwidth[kStreamKernels];
+	for (int kernel=0; kernel<kStreamKernels; ++kernel)
+	{
+		double best = 0.0;
+		for (int n=0; n<std::max(3, iterations / 2); ++n)
+			best = std::max(best, (kStreamCopy == kernel ? 2.0 : 1.0) * kStreamBytes / MeasureStream(kernel, src.data(), dst.data(), threads));
+		bandwidth[kernel] = best;
+	}
+	src = std::vector<uint8_t>();
+	dst = std::vector<uint8_t>();
+
+	double flops = 0.0;
+	for (int n=0; n<3; ++n)
+		flops = std::max(flops, MeasureFlops(threads));
+
+	printf("roofline: %d threads, simd %s (%d lanes)\n", threads, tier, lanes);
+	for (int kernel=0; kernel<kStreamKernels; ++kernel)
+		printf("  %-10s %10.2f GB/s\n", kStreamNames[kernel], bandwidth[kernel] * 1e-9);
+	printf("  %-10s %10.2f GFLOP/s\n", "flops", flops * 1e-9);
+
+	ImageSize(options, 1920, 1080, &width, &height);
+	MakeKernelImages(width, height, &images);
+
+	CasCpuEngine *engine = CasCpuCreate(options.threads);
+	if (!engine)
+	{
+		fprintf(stderr, "cas_bench: cannot create CAS engine\n");
+		return;
+	}
+
+	printf("  %dx%d, %d iterations, roofs in Mpx/s\n", width, height, iterations);
+	printf("  %-10s %-8s %8s %10s %10s %10s %7s %-7s %s\n", "kernel", "quality", "flop/B", "Mpx/s", "memory", "compute", "roof %", "bound", "");
+
+	for (int kernel=0; kernel<kKernels; ++kernel)
+	{
+		for (int quality=0; quality<kCasQualityLevels; ++quality)
+		{
+			RunKernel(engine, images, kernel, options.sharpness, quality);
+
+			double start = Now();
+			for (int n=0; n<iterations; ++n)
+				RunKernel(engine, images, kernel, options.sharpness, quality);
+			double seconds = Now() - start;
+
+			double kernel_flops = KernelFlops(kKernelColors[kernel], quality);
+			double rate = static_cast<double>(width) * height * iterations / seconds;
+			double memory_roof = bandwidth[kStreamCopy] / kKernelBytes[kernel];
+			double compute_roof = flops / kernel_flops;
+			double roof = std::min(memory_roof, compute_roof);
+
+			// Vɑ΂銄40̖_ŕ\
+			char bar[41];
+			int filled = std::clamp(static_cast<int>(rate / roof * 40.0 + 0.5), 0, 40);
+			memset(bar, '#', filled);
+			memset(bar + filled, '.', 40 - filled);
+			bar[40] = '\0';
+
+			printf("  %-10s %-8d %8.2f %10.1f %10.1f %10.1f %7.1f %-7s %s\n", kKernelNames[kernel], quality, kernel_flops / kKernelBytes[kernel], rate * 1e-6, memory_roof * 1e-6, compute_roof * 1e-6, rate / roof * 100.0, memory_roof < compute_roof ? "memory" : "compute", bar);
+		}
+	}
+
+	CasCpuDestroy(engine);
+}
+
+// worker_node ̃[J[ŁAmemory_node ɒu摜ꍇ1t[̕bAsꍇ͕
+// ďõXbhɉ邽߁Av worker_node ɌŒ肵Xbhōs
+static double MeasureNuma(const BenchOptions &options, int width, int height, int iterations, int worker_node, int memory_node)
+{
+	size_t pitch = CasArenaPitch(static_cast<size_t>(width) * 4);
+	size_t size = pitch * height;
+
+	CasArena arena;
+	if (!CasArenaCreateOnNode(&arena, size * 2, false, memory_node))
+		return -1.0;
+
+	CasCpuEngine *engine = CasCpuCreateOnNode(options.threads, worker_node);
+	if (!engine)
+	{
+		CasArenaDestroy(&arena);
+		return -1.0;
+	}
+
+	double seconds = -1.0;
+	std::thread runner([&]
+	{
+		CasNumaPinThread(worker_node);
+
+		CasCpuImage src;
+		src.pixels = static_cast<uint8_t *>(CasArenaAlloc(&arena, size));
+		src.pitch = static_cast<ptrdiff_t>(pitch);
+		src.width = width;
+		src.height = height;
+		CasCpuImage dst = src;
+		dst.pixels = static_cast<uint8_t *>(CasArenaAlloc(&arena, size));
+
+		std::mt19937 random(1);
+		for (size_t i=0; i<size; ++i)
+			src.pixels[i] = static_cast<uint8_t>(random());
+		memset(dst.pixels, 0, size);
+
+		CasCpuFilter(engine, &src, &dst, options.sharpness, options.quality);
+
+		double start = Now();
+		for (int n=0; n<iterations; ++n)
+			CasCpuFilter(engine, &src, &dst, options.sharpness, options.quality);
+		seconds = (Now() - start) / iterations;
+	});
+	runner.join();
+
+	CasCpuDestroy(engine);
+	CasArenaDestroy(&arena);
+
+	return seconds;
+}
+
+// [J[uNUMAm[hƁA摜uNUMAm[h̑gƂ̏
+// m[hɒuꍇ (local) ƁAʂ̃m[hɒuꍇ (remote) ̕ςׂ
+static void BenchNuma(const BenchOptions &options)
+{
+	int width;
+	int height;
+
+	int iterations = Iterations(options, 5);
+	int nodes = CasNumaNodeCount();
+
+	ImageSize(options, 3840, 2160, &width, &height);
+
+	printf("numa: %dx%d, %d nodes, %d iterations\n", width, height, nodes, iterations);
+	printf("  %-8s %-8s %-8s %12s %12s\n", "workers", "memory", "access", "ms/frame", "ns/px");
+
+	double local_seconds = 0.0;
+	double remote_seconds = 0.0;
+	int local_count = 0;
+	int remote_count = 0;
+
+	for (int worker_node=0; worker_node<nodes; ++worker_node)
+	{
+		for (int memory_node=0; memory_node<nodes; ++memory_node)
+		{
+			double seconds = MeasureNuma(options, width, height, iterations, worker_node, memory_node);
+			if (seconds < 0.0)
+			{
+				fprintf(stderr, "cas_bench: cannot run on node %d with memory on node %d\n", worker_node, memory_node);
+				continue;
+			}
+
+			bool local = worker_node == memory_node;
+			printf("  %-8d %-8d %-8s %12.3f %12.3f\n", worker_node, memory_node, local ? "local" : "remote", seconds * 1e3, seconds / (static_cast<double>(width) * height) * 1e9);
+
+			(local ? local_seconds : remote_seconds) += seconds;
+			++(local ? local_count : remote_count);
+		}
+	}
+
+	if (local_count && remote_count)
+		printf("  remote / local: %.2fx\n", remote_seconds / remote_count / (local_seconds / local_count));
+	else
+		printf("  remote / local: n/a (single NUMA node)\n");
+}
+
+static const Bench kBenches[] =
+{
+	{"batch", "per-image overhead of CasCpuFilter versus CasCpuFilterBatch", BenchBatch},
+	{"fused", "direct picture-to-picture CAS versus copy in, CAS, copy out", BenchFused},
+	{"strips", "time per pixel from 1080p to 8K with and without column strips", BenchStrips},
+	{"frames", "tile-parallel versus frame-parallel throughput on small frames", BenchFrames},
+	{"queue", "frame hand-off latency of the lock-free SPSC queue versus a mutex queue", BenchQueue},
+	{"hugepages", "8K frame time with frame buffers on small pages versus huge pages", BenchHugePages},
+	{"alloc", "heap allocations per frame with scratch handed over up front (expects 0)", BenchAlloc},
+	{"kernels", "time and pixel rate of every CAS kernel and quality, with -p hardware counters", BenchKernels},
+	{"roofline", "memory bandwidth and peak FLOPs of the host, and every CAS kernel against them", BenchRoofline},
+	{"numa", "4K frame time for each worker node and memory node pair, local versus remote", BenchNuma},
+};
+
+static void PrintUsage()
+{
+	fprintf(stderr,
+		"usage: cas_bench [options] [benchmark ...]\n"
+		"  -t, --threads N       CAS threads (default: logical processors)\n"
+		"  -s, --size WxH        image size (default: depends on the benchmark)\n"
+		"  -n, --count N         images per batch or frames in a sequence (default: 64)\n"
+		"  -i, --iterations N    repetitions (default: depends on the benchmark)\n"
+		"  -q, --quality N       quality 0-3 (default: 0)\n"
+		"  -S, --sharpness N     sharpness [0, 1] (default: 0.8)\n"
+		"  -p, --perf            also read hardware counters (kernels, hugepages)\n"
+		"  -h, --help\n"
+		"benchmarks (default: all):\n");
+	for (const Bench &bench : kBenches)
+		fprintf(stderr, "  %-20s  %s\n", bench.name, bench.description);
+}
+
+int main(int argc, char **argv)
+{
+	BenchOptions options;
+	std::vector<const Bench *> benches;
+
+	options.threads = 0;
+	options.width = 0;
+	options.height = 0;
+	options.count = 64;
+	options.iterations = 0;
+	options.quality = kCasQualityBest;
+	options.sharpness = 0.8f;
+	options.perf = false;
+
+	for (int i=1; i<argc; ++i)
+	{
+		std::string arg = argv[i];
+		const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+		bool ok = true;
+
+		if ("-h" == arg || "--help" == arg)
+		{
+			PrintUsage();
+			return EXIT_SUCCESS;
+		}
+		else if ("-p" == arg || "--perf" == arg)
+		{
+			options.perf = true;
+		}
+		else if (("-t" == arg || "--threads" == arg) && value)
+		{
+			options.threads = std::max(0, atoi(value));
+			++i;
+		}
+		else if (("-s" == arg || "--size" == arg) && value)
+		{
+			ok = 2 == sscanf(value, "%dx%d", &options.width, &options.height) && 0 < options.width && 0 < options.height;
+			++i;
+		}
+		else if (("-n" == arg || "--count" == arg) && value)
+		{
+			options.count = std::max(1, atoi(value));
+			++i;
+		}
+		else if (("-i" == arg || "--iterations" == arg) && value)
+		{
+			options.iterations = std::max(1, atoi(value));
+			++i;
+		}
+		else if (("-q" == arg || "--quality" == arg) && value)
+		{
+			options.quality = std::clamp(atoi(value), 0, kCasQualityLevels - 1);
+			++i;
+		}
+		else if (("-S" == arg || "--sharpness" == arg) && value)
+		{
+			options.sharpness = std::clamp(static_cast<float>(atof(value)), 0.0f, 1.0f);
+			++i;
+		}
+		else
+		{
+			const Bench *found = nullptr;
+			for (const Bench &bench : kBenches)
+			{
+				if (arg == bench.name)
+					found = &bench;
+			}
+			ok = nullptr != found;
+			benches.push_back(found);
+		}
+
+		if (!ok)
+		{
+			PrintUsage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (benches.empty())
+	{
+		for (const Bench &bench : kBenches)
+			benches.push_back(&bench);
+	}
+
+	for (const Bench *bench : benches)
+		bench->function(options);
+
+	return g_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
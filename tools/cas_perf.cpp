@@ -0,0 +1,121 @@
+#include <string.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "cas_perf.h"
+
+
+static const char *const kPerfCounterNames[kPerfCounters] = {"cycles", "instructions", "L1D misses", "LLC misses", "dTLB misses"};
+
+#ifdef __linux__
+static uint64_t CacheConfig(uint64_t cache, uint64_t op, uint64_t result)
+{
+	return cache | (op << 8) | (result << 16);
+}
+
+// JE^1JAJȂꍇ-1
+// O[vɂƁApXbh̒lǂ߂ȂJ[l邽߁AJE^ƂɊJ
+static int OpenCounter(uint32_t type, uint64_t config)
+{
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof (attr));
+	attr.size = sizeof (attr);
+	attr.type = type;
+	attr.config = config;
+	attr.disabled = 1;
+	attr.inherit = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+	return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+bool PerfOpen(PerfCounters *counters)
+{
+	counters->fds[kPerfCycles] = OpenCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+	counters->fds[kPerfInstructions] = OpenCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+	counters->fds[kPerfL1dMisses] = OpenCounter(PERF_TYPE_HW_CACHE, CacheConfig(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS));
+	counters->fds[kPerfLlcMisses] = OpenCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+	counters->fds[kPerfDtlbMisses] = OpenCounter(PERF_TYPE_HW_CACHE, CacheConfig(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS));
+
+	for (int fd : counters->fds)
+	{
+		if (0 <= fd)
+			return true;
+	}
+
+	return false;
+}
+
+void PerfClose(PerfCounters *counters)
+{
+	for (int &fd : counters->fds)
+	{
+		if (0 <= fd)
+			close(fd);
+		fd = -1;
+	}
+}
+
+void PerfStart(PerfCounters *counters)
+{
+	for (int fd : counters->fds)
+	{
+		if (fd < 0)
+			continue;
+		ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+		ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+	}
+}
+
+void PerfStop(PerfCounters *counters, PerfSample *sample)
+{
+	for (int fd : counters->fds)
+	{
+		if (0 <= fd)
+			ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+	}
+
+	for (int i=0; i<kPerfCounters; ++i)
+	{
+		uint64_t values[3]; // lALԁAĂ
+		sample->valid[i] = 0 <= counters->fds[i] && static_cast<ssize_t>(sizeof (values)) == read(counters->fds[i], values, sizeof (values)) && values[2];
+		sample->values[i] = sample->valid[i] ? static_cast<double>(values[0]) * values[1] / values[2] : 0.0;
+	}
+}
+#else
+bool PerfOpen(PerfCounters *counters)
+{
+	for (int &fd : counters->fds)
+		fd = -1;
+	return false;
+}
+
+void PerfClose(PerfCounters *counters)
+{
+}
+
+void PerfStart(PerfCounters *counters)
+{
+}
+
+void PerfStop(PerfCounters *counters, PerfSample *sample)
+{
+	for (int i=0; i<kPerfCounters; ++i)
+	{
+		sample->valid[i] = false;
+		sample->values[i] = 0.0;
+	}
+}
+#endif
+
+const char *PerfCounterName(int counter)
+{
+	return kPerfCounterNames[counter];
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdint.h>
+
+
+// x`}[NŌvԂ́ACPU̐\JE^
+// Linux  perf_event_open ŐAgȂJE^͖Ƃ
+enum PerfCounter
+{
+	kPerfCycles = 0,
+	kPerfInstructions,
+	kPerfL1dMisses, // L1f[^LbV̓Ǎ̃~X
+	kPerfLlcMisses, // ŏIĩLbṼ~X
+	kPerfDtlbMisses, // f[^TLB̓Ǎ̃~X
+	kPerfCounters
+};
+
+struct PerfSample
+{
+	double values[kPerfCounters]; // dĐꍇ́AԂ̊ŕ␳l
+	bool valid[kPerfCounters];
+};
+
+struct PerfCounters
+{
+	int fds[kPerfCounters]; // JȂJE^-1
+};
+
+// ďõXbhƁAȍ~ɍXbh𐔂JE^J
+// GW̃[J[邽߁ACasCpuCreate ̑OɊJ
+// 1JȂꍇ͋UԂ
+bool PerfOpen(PerfCounters *counters);
+void PerfClose(PerfCounters *counters);
+
+// l0ɖ߂Đn߂
+void PerfStart(PerfCounters *counters);
+
+// ̂~߁AJn̒l sample ɏ
+void PerfStop(PerfCounters *counters, PerfSample *sample);
+
+const char *PerfCounterName(int counter);
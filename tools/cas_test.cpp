@@ -0,0 +1,606 @@
+// CPUłCAS̏AfƂɑfɋ߂QƂ̎Ɣׂ
+// QƂ̎ ffx_cas.h  CasFilter (noScaling ^̏ꍇ) 1f̂ŁA
+// ŏlƍől͏\3x3̉f狁߁A񂲂Ƃ̎g񂵁AZAтւ͍̕sȂ
+// vȂfΎs̏IR[hԂACTest Ōo
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#define A_CPU 1
+#include "ffx_a.h"
+
+#include "cas_cpu.h"
+
+
+// rɎsAIR[h EXIT_FAILURE ɂ
+static bool g_failed = false;
+
+// sڂ\ő̉
+static const int kMaxReports = 10;
+static int g_reports = 0;
+
+// cas_cpu.cpp Ɠd݂̕\݂̍ƁA`lsRGBlւ̕ϊ\̑傫
+static const int kWeightMantissaBits = 8;
+static const int kWeightOctaves = 14;
+static const int kWeightSteps = kWeightOctaves << kWeightMantissaBits;
+static const int kLinearToSrgbSize = 65536;
+
+static AF1 g_srgb_to_linear[256];
+static AB1 g_linear_to_srgb[kLinearToSrgbSize];
+
+// 摜̒[ŉf̊OɒuAĂȂƂm߂l
+static const uint8_t kGuard = 0xa5;
+static const int kGuardBytes = 8;
+
+// ͂̉摜̓e
+enum TestPattern
+{
+	kPatternRandom = 0, // lȗ
+	kPatternBlack, // S0Aől0ŋtɂȂ
+	kPatternWhite, // S255
+	kPatternBinary, // 0255̗Aŏlƍől[̒lɂȂ
+	kPatternFlat, // Ԃ̒l̋߂̏ȗh炬Aamp d݂̕\ׂ݂̍ʂ
+	kPatterns
+};
+static const char *const kPatternNames[kPatterns] = {"random", "black", "white", "binary", "flat"};
+
+// 摜Aš kGuardBytes ̗]u
+struct TestImage
+{
+	std::vector<uint8_t> pixels;
+	int width;
+	int height;
+	int channels;
+	ptrdiff_t pitch;
+};
+
+// QƂ̎̏d݂̋ߕ
+enum ReferenceWeights
+{
+	kWeightsTable = 0, // cas_cpu.cpp Ɠ݂̕\AœKƈv
+	kWeightsDirect, // ffx_cas.h ƓfƂɕƋt߂A\݂̍̕قȂ
+};
+
+// QƂ̎Ɣׂ鏈̏
+struct TestCase
+{
+	int channels;
+	int width;
+	int height;
+	int pattern;
+	unsigned flags;
+	float sharpness;
+	int threads;
+	size_t strip_bytes;
+	bool in_place;
+};
+
+
+static void InitTables()
+{
+	for (int i=0; i<256; ++i)
+	{
+		double c = i / 255.0;
+		g_srgb_to_linear[i] = static_cast<AF1>(c <= 0.04045 ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4));
+	}
+
+	for (int i=0; i<kLinearToSrgbSize; ++i)
+	{
+		double c = static_cast<double>(i) / (kLinearToSrgbSize - 1);
+		double s = c <= 0.0031308 ? c * 12.92 : 1.055 * pow(c, 1.0 / 2.4) - 0.055;
+		g_linear_to_srgb[i] = static_cast<AB1>(std::min(255.0, s * 255.0 + 0.5));
+	}
+}
+
+static AF1 AF1FromBits(AU1 a)
+{
+	AF1 f;
+	memcpy(&f, &a, sizeof (f));
+	return f;
+}
+
+// ffx_a.h  AMin3F1  AMax3F1ACPUɂ͗pӂĂȂ
+static AF1 AMin3F1(AF1 x, AF1 y, AF1 z)
+{
+	return AMinF1(x, AMinF1(y, z));
+}
+
+static AF1 AMax3F1(AF1 x, AF1 y, AF1 z)
+{
+	return AMaxF1(x, AMaxF1(y, z));
+}
+
+// HLSLsaturateƓ NaN 0Ƃ
+static AF1 Saturate(AF1 a)
+{
+	return AMinF1(AMaxF1(a, AF1_(0.0)), AF1_(1.0));
+}
+
+// ffx_a.h  APrxLoRcpF1AAPrxLoSqrtF1AAPrxMedRcpF1 Ɠߎ
+static AF1 APrxLoRcpF1(AF1 a)
+{
+	return AF1FromBits(AU1_(0x7ef07ebb) - AU1_AF1(a));
+}
+
+static AF1 APrxLoSqrtF1(AF1 a)
+{
+	return AF1FromBits((AU1_AF1(a) >> AU1_(1)) + AU1_(0x1fbc4639));
+}
+
+static AF1 APrxMedRcpF1(AF1 a)
+{
+	AF1 b = AF1FromBits(AU1_(0x7ef19fff) - AU1_AF1(a));
+	return b * (-b * a + AF1_(2.0));
+}
+
+static AB1 ToSrgb(AF1 c)
+{
+	return g_linear_to_srgb[static_cast<int>(c * (kLinearToSrgbSize - 1) + AF1_(0.5))];
+}
+
+// CasSetup  const1.x ɒu peak
+static AF1 Peak(float sharpness)
+{
+	return -ARcpF1(ALerpF1(AF1_(8.0), AF1_(5.0), ASatF1(sharpness)));
+}
+
+// d݂̕\̓YƁAYɑΉ amp (݂̒)
+static int WeightIndex(AF1 amp)
+{
+	int index = static_cast<int>(AU1_AF1(amp) >> (23 - kWeightMantissaBits)) - ((127 - kWeightOctaves) << kWeightMantissaBits) + 1;
+	return std::max(index, 0);
+}
+
+static AF1 WeightAmp(int index)
+{
+	if (0 == index)
+		return AF1_(0.0);
+	if (kWeightSteps + 1 == index)
+		return AF1_(1.0);
+	AU1 bits = static_cast<AU1>(index - 1 + ((127 - kWeightOctaves) << kWeightMantissaBits)) << (23 - kWeightMantissaBits);
+	bits += AU1_(1) << (22 - kWeightMantissaBits);
+	return AF1FromBits(bits);
+}
+
+// amp 狁߂d w ƁA1 / (1 + 4w)
+struct Weight
+{
+	AF1 w;
+	AF1 rcp_weight;
+};
+
+static Weight DirectWeight(AF1 amp, AF1 peak, bool go_slower)
+{
+	Weight weight;
+	weight.w = (go_slower ? sqrtf(amp) : APrxLoSqrtF1(amp)) * peak;
+	weight.rcp_weight = go_slower ? ARcpF1(AF1_(1.0) + AF1_(4.0) * weight.w) : APrxMedRcpF1(AF1_(1.0) + AF1_(4.0) * weight.w);
+	return weight;
+}
+
+// ݂Ƃ̏d݂̕\
+// peak ƐxOƓꍇ͍蒼Ȃ
+static const Weight *WeightTable(AF1 peak, bool go_slower)
+{
+	static std::vector<Weight> table;
+	static AF1 table_peak;
+	static bool table_go_slower;
+
+	if (table.empty() || table_peak != peak || table_go_slower != go_slower)
+	{
+		table.resize(kWeightSteps + 2);
+		for (int i=0; i<=kWeightSteps + 1; ++i)
+			table[i] = DirectWeight(WeightAmp(i), peak, go_slower);
+		table_peak = peak;
+		table_go_slower = go_slower;
+	}
+
+	return table.data();
+}
+
+// 摜̊O͒[̉fJԂ
+static AF1 Load(const TestImage &image, int x, int y, int ch)
+{
+	x = std::clamp(x, 0, image.width - 1);
+	y = std::clamp(y, 0, image.height - 1);
+	return g_srgb_to_linear[image.pixels[image.pitch * y + image.channels * x + ch]];
+}
+
+// QƂ̎
+// kWeightsTable ̏ꍇ́Ad݂ cas_cpu.cpp Ɠ݂̕\߁AœKƈvȂ΂ȂȂ
+// kWeightsDirect ̏ꍇ́Affx_cas.h ƓfƂɕƋt߁Aaɋ߂
+static void ReferenceFilter(const TestImage &src, TestImage *dst, float sharpness, unsigned flags, ReferenceWeights mode)
+{
+	const bool slow = 0 != (kCasSlow & flags) && 4 == src.channels;
+	const bool go_slower = 0 != (kCasGoSlower & flags);
+	const bool better_diagonals = 0 != (kCasBetterDiagonals & flags);
+	const int colors = 4 == src.channels ? 3 : 1;
+	const int green = 4 == src.channels ? 1 : 0;
+	const AF1 peak = Peak(sharpness);
+	const Weight *table = WeightTable(peak, go_slower);
+
+	for (int y=0; y<src.height; ++y)
+	{
+		for (int x=0; x<src.width; ++x)
+		{
+			Weight weights[3];
+			for (int ch=0; ch<colors; ++ch)
+			{
+				// a b c
+				// d e f
+				// g h i
+				AF1 a = Load(src, x - 1, y - 1, ch);
+				AF1 b = Load(src, x, y - 1, ch);
+				AF1 c = Load(src, x + 1, y - 1, ch);
+				AF1 d = Load(src, x - 1, y, ch);
+				AF1 e = Load(src, x, y, ch);
+				AF1 f = Load(src, x + 1, y, ch);
+				AF1 g = Load(src, x - 1, y + 1, ch);
+				AF1 h = Load(src, x, y + 1, ch);
+				AF1 i = Load(src, x + 1, y + 1, ch);
+
+				AF1 mn = AMin3F1(AMin3F1(d, e, f), b, h);
+				AF1 mx = AMax3F1(AMax3F1(d, e, f), b, h);
+				if (better_diagonals)
+				{
+					AF1 mn2 = AMin3F1(AMin3F1(mn, a, c), g, i);
+					AF1 mx2 = AMax3F1(AMax3F1(mx, a, c), g, i);
+					mn = mn + mn2;
+					mx = mx + mx2;
+				}
+
+				AF1 rcp_m = go_slower ? ARcpF1(mx) : APrxLoRcpF1(mx);
+				AF1 amp = Saturate(AMinF1(mn, (better_diagonals ? AF1_(2.0) : AF1_(1.0)) - mx) * rcp_m);
+				weights[ch] = kWeightsTable == mode ? table[WeightIndex(amp)] : DirectWeight(amp, peak, go_slower);
+			}
+
+			uint8_t *out = &dst->pixels[dst->pitch * y + dst->channels * x];
+			for (int ch=0; ch<colors; ++ch)
+			{
+				const Weight &weight = weights[slow ? ch : green];
+				AF1 b = Load(src, x, y - 1, ch);
+				AF1 d = Load(src, x - 1, y, ch);
+				AF1 e = Load(src, x, y, ch);
+				AF1 f = Load(src, x + 1, y, ch);
+				AF1 h = Load(src, x, y + 1, ch);
+				AF1 value = kWeightsTable == mode ? (b + d + f + h) * weight.w + e : b * weight.w + d * weight.w + f * weight.w + h * weight.w + e;
+				out[ch] = ToSrgb(Saturate(value * weight.rcp_weight));
+			}
+			if (4 == src.channels)
+				out[3] = 0xff;
+		}
+	}
+}
+
+static void MakeImage(int channels, int width, int height, TestImage *image)
+{
+	image->width = width;
+	image->height = height;
+	image->channels = channels;
+	image->pitch = static_cast<ptrdiff_t>(width) * channels + kGuardBytes;
+	image->pixels.assign(image->pitch * height, kGuard);
+}
+
+static void FillImage(int pattern, std::mt19937 *random, TestImage *image)
+{
+	for (int y=0; y<image->height; ++y)
+	{
+		uint8_t *row = &image->pixels[image->pitch * y];
+		for (int i=0; i<image->width * image->channels; ++i)
+		{
+			uint32_t r = (*random)();
+			switch (pattern)
+			{
+			case kPatternRandom: row[i] = static_cast<uint8_t>(r); break;
+			case kPatternBlack: row[i] = 0; break;
+			case kPatternWhite: row[i] = 0xff; break;
+			case kPatternBinary: row[i] = (r & 1) ? 0xff : 0; break;
+			case kPatternFlat: row[i] = static_cast<uint8_t>(126 + r % 5); break;
+			}
+		}
+	}
+}
+
+// CasCpuImage  pixels  const ł͂ȂA͂Ƃēnꍇ͏Ȃ
+static CasCpuImage View(const TestImage &image)
+{
+	CasCpuImage view;
+	view.pixels = const_cast<uint8_t *>(image.pixels.data());
+	view.pitch = image.pitch;
+	view.width = image.width;
+	view.height = image.height;
+	return view;
+}
+
+// s detail \
+static void Report(const TestCase &test, const char *detail)
+{
+	g_failed = true;
+	if (kMaxReports <= g_reports++)
+		return;
+
+	printf("  FAIL %s %dx%d %s flags %u sharpness %.2f threads %d strip %zu%s: %s\n",
+		4 == test.channels ? "bgra" : "plane", test.width, test.height, kPatternNames[test.pattern], test.flags, test.sharpness,
+		test.threads, test.strip_bytes, test.in_place ? " in-place" : "", detail);
+}
+
+// fƍš̗]ׁAŏɈقȂf񍐂
+// vꍇ͐^Ԃ
+static bool CompareExact(const TestCase &test, const TestImage &expected, const TestImage &actual)
+{
+	if (expected.pixels == actual.pixels)
+		return true;
+
+	for (size_t i=0; i<expected.pixels.size(); ++i)
+	{
+		if (expected.pixels[i] != actual.pixels[i])
+		{
+			char detail[128];
+			int offset = static_cast<int>(i % expected.pitch);
+			snprintf(detail, sizeof (detail), "(%d, %d) channel %d, expected %d, got %d",
+				offset / test.channels, static_cast<int>(i / expected.pitch), offset % test.channels, expected.pixels[i], actual.pixels[i]);
+			Report(test, detail);
+			break;
+		}
+	}
+
+	return false;
+}
+
+// QƂ̎ƍœK1̏Ŕׂ
+// sv̉摜1ƐĕԂ
+static int RunCase(CasCpuEngine *engine, const TestCase &test, const TestImage &src)
+{
+	TestImage expected;
+	MakeImage(test.channels, test.width, test.height, &expected);
+	ReferenceFilter(src, &expected, test.sharpness, test.flags, kWeightsTable);
+
+	TestImage actual;
+	if (test.in_place)
+	{
+		actual = src;
+	}
+	else
+	{
+		MakeImage(test.channels, test.width, test.height, &actual);
+	}
+
+	CasCpuImage src_view = View(src);
+	CasCpuImage actual_view = View(actual);
+	bool filtered = test.in_place
+		? CasCpuFilterFlags(engine, test.channels, &actual_view, nullptr, test.sharpness, test.flags)
+		: CasCpuFilterFlags(engine, test.channels, &src_view, &actual_view, test.sharpness, test.flags);
+	if (!filtered)
+	{
+		Report(test, "filter returned false");
+		return 1;
+	}
+
+	// QƂ̏o̗͂]͓͂Ɠ kGuardȀŏꍇ͓̗͂]̂܂܎c
+	return CompareExact(test, expected, actual) ? 0 : 1;
+}
+
+// c̒ZƑт̋Eʂ傫
+// 13̕ƍAт̍s (16) ̑O̍AkStripBytes ł̒Z̔̕{̑O̕܂߂
+static const int kSizes[][2] =
+{
+	{1, 1}, {1, 2}, {1, 3}, {2, 1}, {2, 2}, {2, 3}, {3, 1}, {3, 2}, {3, 3},
+	{4, 15}, {5, 16}, {7, 17}, {9, 33}, {31, 31},
+	{84, 3}, {85, 5}, {86, 17}, {171, 2}, {255, 3}, {256, 2}, {257, 4}, {513, 2},
+};
+
+// Z1s̃oCgA0 ͒ZɕȂꍇ
+// `lBGRA1f12oCgA1`l1f4oCĝ߁A
+// ŏ1024oCgłBGRA85fA1`l256fA2048oCgł͂2{̒̕ZɂȂ
+static const size_t kStripBytes[] = {0, 1024, 2048};
+
+static const float kSharpness[] = {0.0f, 0.3f, 0.8f, 1.0f};
+
+static void TestBitExact()
+{
+	printf("bit-exact: optimized kernels against the per-pixel reference\n");
+
+	std::mt19937 random(1);
+	for (int threads : {1, 3})
+	{
+		CasCpuEngine *engine = CasCpuCreate(threads);
+		if (!engine)
+		{
+			printf("  FAIL cannot create CAS engine\n");
+			g_failed = true;
+			return;
+		}
+
+		for (int channels : {4, 1})
+		{
+			for (unsigned flags=0; flags<kCasFlagCombinations; ++flags)
+			{
+				int images = 0;
+				int mismatches = 0;
+
+				for (size_t strip_bytes : kStripBytes)
+				{
+					CasCpuSetStripBytes(engine, strip_bytes);
+
+					for (const int *size : kSizes)
+					{
+						for (int pattern=0; pattern<kPatterns; ++pattern)
+						{
+							TestImage src;
+							MakeImage(channels, size[0], size[1], &src);
+							FillImage(pattern, &random, &src);
+
+							for (float sharpness : kSharpness)
+							{
+								for (bool in_place : {false, true})
+								{
+									TestCase test = {channels, size[0], size[1], pattern, flags, sharpness, threads, strip_bytes, in_place};
+									mismatches += RunCase(engine, test, src);
+									++images;
+								}
+							}
+						}
+					}
+				}
+
+				printf("  %-5s flags %u threads %d: %6d images, %d mismatched%s\n", 4 == channels ? "bgra" : "plane", flags, threads, images, mismatches, mismatches ? " FAIL" : "");
+			}
+		}
+
+		CasCpuDestroy(engine);
+	}
+}
+
+// iiK󂯎J̊֐AtȎgݍ킹Ɠ̂ĂԂƂm߂
+static void TestQualityEntryPoints()
+{
+	printf("quality: CasCpuFilter* against the flag combination of each quality\n");
+
+	std::mt19937 random(2);
+	CasCpuEngine *engine = CasCpuCreate(2);
+	if (!engine)
+	{
+		printf("  FAIL cannot create CAS engine\n");
+		g_failed = true;
+		return;
+	}
+
+	for (int channels : {4, 1})
+	{
+		for (int quality=0; quality<kCasQualityLevels; ++quality)
+		{
+			TestImage src;
+			MakeImage(channels, 97, 41, &src);
+			FillImage(kPatternRandom, &random, &src);
+
+			TestImage expected;
+			MakeImage(channels, src.width, src.height, &expected);
+			ReferenceFilter(src, &expected, 0.6f, CasQualityFlags(quality), kWeightsTable);
+
+			TestImage out;
+			MakeImage(channels, src.width, src.height, &out);
+			TestImage in_place = src;
+			TestImage batch;
+			MakeImage(channels, src.width, src.height, &batch);
+
+			CasCpuImage src_view = View(src);
+			CasCpuImage out_view = View(out);
+			CasCpuImage in_place_view = View(in_place);
+			CasCpuBatchItem item = {src_view, View(batch), 0.6f};
+
+			bool filtered;
+			if (4 == channels)
+			{
+				filtered = CasCpuFilter(engine, &src_view, &out_view, 0.6f, quality);
+				filtered &= CasCpuFilterInPlace(engine, &in_place_view, 0.6f, quality);
+				filtered &= CasCpuFilterBatch(engine, &item, 1, quality);
+			}
+			else
+			{
+				filtered = CasCpuFilterPlane(engine, &src_view, &out_view, 0.6f, quality);
+				filtered &= CasCpuFilterPlaneInPlace(engine, &in_place_view, 0.6f, quality);
+				filtered &= CasCpuFilterPlaneBatch(engine, &item, 1, quality);
+			}
+
+			TestCase test = {channels, src.width, src.height, kPatternRandom, CasQualityFlags(quality), 0.6f, 2, CasCpuStripBytes(engine), false};
+			bool same = filtered && CompareExact(test, expected, out) && CompareExact(test, expected, batch);
+			test.in_place = true;
+			same = same && CompareExact(test, expected, in_place);
+			g_failed |= !same;
+
+			printf("  %-5s quality %d: %s\n", 4 == channels ? "bgra" : "plane", quality, same ? "ok" : "FAIL");
+		}
+	}
+
+	CasCpuDestroy(engine);
+}
+
+// d݂̕\p鏈ƁAfƂɕƋt߂ ffx_cas.h ̏Ƃ̍AsRGB 1ȉł邱Ƃm߂
+// iiKƂɁA01܂ދŁAamp ͈̔͂Lʂ摜ׂ
+static void TestWeightTable()
+{
+	printf("weights: weight table against the direct sqrt/rcp chain (max |diff| <= 1)\n");
+
+	static const float kTableSharpness[] = {0.0f, 0.1f, 0.25f, 0.5f, 0.75f, 0.9f, 1.0f};
+	static const int kTablePatterns[] = {kPatternRandom, kPatternBinary, kPatternFlat};
+
+	std::mt19937 random(3);
+	std::vector<TestImage> images;
+	for (int channels : {4, 1})
+	{
+		for (int pattern : kTablePatterns)
+		{
+			TestImage image;
+			MakeImage(channels, 193, 67, &image);
+			FillImage(pattern, &random, &image);
+			images.push_back(image);
+		}
+	}
+
+	CasCpuEngine *engine = CasCpuCreate(2);
+	if (!engine)
+	{
+		printf("  FAIL cannot create CAS engine\n");
+		g_failed = true;
+		return;
+	}
+
+	for (int quality=0; quality<kCasQualityLevels; ++quality)
+	{
+		for (float sharpness : kTableSharpness)
+		{
+			int max_diff = 0;
+			size_t differing = 0;
+			size_t pixels = 0;
+
+			for (const TestImage &src : images)
+			{
+				TestImage expected;
+				MakeImage(src.channels, src.width, src.height, &expected);
+				ReferenceFilter(src, &expected, sharpness, CasQualityFlags(quality), kWeightsDirect);
+
+				TestImage actual;
+				MakeImage(src.channels, src.width, src.height, &actual);
+				CasCpuImage src_view = View(src);
+				CasCpuImage actual_view = View(actual);
+				bool filtered = 4 == src.channels
+					? CasCpuFilter(engine, &src_view, &actual_view, sharpness, quality)
+					: CasCpuFilterPlane(engine, &src_view, &actual_view, sharpness, quality);
+				if (!filtered)
+					max_diff = 256;
+
+				for (size_t i=0; i<expected.pixels.size(); ++i)
+				{
+					int diff = abs(expected.pixels[i] - actual.pixels[i]);
+					max_diff = std::max(max_diff, diff);
+					differing += 0 != diff;
+				}
+				pixels += expected.pixels.size();
+			}
+
+			bool failed = 1 < max_diff;
+			g_failed |= failed;
+			printf("  quality %d sharpness %.2f: max |diff| %d, %zu of %zu bytes differ%s\n", quality, sharpness, max_diff, differing, pixels, failed ? " FAIL" : "");
+		}
+	}
+
+	CasCpuDestroy(engine);
+}
+
+int main()
+{
+	InitTables();
+
+	TestBitExact();
+	TestQualityEntryPoints();
+	TestWeightTable();
+
+	printf("%s\n", g_failed ? "FAILED" : "passed");
+	return g_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,878 @@
+// CASKpR}hCc[
+// BGRAAI420A܂Y4Mt@CW͂ǂ݁At@CWo͂ɏ
+// ǍACASAo͂ꂼʂ̃XbhōsAXbhԂ̓bNȂ̂L[łȂ
+// ͂ʏ̃t@C̏ꍇmmapAt[Rs[ɂ̂܂CASɓn
+// o͂ʏ̃t@C̏ꍇ́Aio_uring ŕt[̏𓯎ɍs
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include "cas_arena.h"
+#include "cas_cpu.h"
+#include "cas_numa.h"
+#include "cas_queue.h"
+#include "cas_trace.h"
+#if CAS_HAVE_IO_URING
+#include "cas_uring.h"
+#endif
+
+
+// o͂̌`
+enum FrameFormat
+{
+	kFormatY4m,
+	kFormatBgra,
+	kFormatI420,
+};
+
+// Y4M̐F̌`
+enum Y4mChroma
+{
+	kY4mChroma420,
+	kY4mChromaMono,
+};
+
+struct Options
+{
+	FrameFormat format;
+	int width;
+	int height;
+	float sharpness;
+	int quality;
+	int threads;
+	int depth;
+	int numa_node; // ̏ꍇ͎w肵Ȃ
+	const char *trace_path; // nullptr ̏ꍇ̓g[XL^Ȃ
+	bool quiet;
+	const char *input_path;
+	const char *output_path;
+};
+
+// ͂1t[̑傫ƁAʂ̔zu
+struct FrameLayout
+{
+	bool bgra; // ȔꍇA擪ɋPx̕ʂ
+	int width;
+	int height;
+	size_t luma_size; // BGRȀꍇ̓t[S
+	size_t frame_size;
+};
+
+// t[̗̈́A܂Ƃ߂1 CasArena ؂o
+struct Frame
+{
+	uint8_t *input; // mmapłȂꍇ̓
+	uint8_t *output; // CAŠʁAPx̕ʂ`ł͋Px̂
+	const uint8_t *view; // ͂̃t[Ainput mmap̈w
+};
+
+struct Input
+{
+	FILE *file;
+	const uint8_t *map; // mmap͑ŚAmmapłȂꍇnullptr
+	size_t map_size;
+	size_t map_pos; // ɓǂވʒu
+};
+
+struct Output
+{
+	FILE *file;
+#if CAS_HAVE_IO_URING
+	UringWriter *uring; // io_uring ŏꍇ
+	uint64_t offset; // io_uring Ŏɏʒu
+#endif
+};
+
+struct Pipeline
+{
+	const Options *options;
+	FrameLayout layout;
+	FrameFormat format;
+	Input *input;
+	Output *output;
+	CasCpuEngine *engine;
+	SpscQueue<Frame *> *free_frames; // Ǎ҂̃t[
+	SpscQueue<Frame *> *work_frames; // CAS҂̃t[Anullptr͏I[
+	SpscQueue<Frame *> *write_frames; // o҂̃t[Anullptr͏I[
+	std::atomic<bool> failed;
+	uint64_t frame_count;
+};
+
+
+static void PrintUsage()
+{
+	fprintf(stderr,
+		"usage: cas [options] [input [output]]\n"
+		"  input and output default to stdin and stdout, '-' also selects them\n"
+		"  -f, --format FORMAT   y4m, bgra or i420 (default: y4m)\n"
+		"  -s, --size WxH        frame size of bgra and i420 input\n"
+		"  -S, --sharpness N     sharpness [0, 1] (default: 0.8)\n"
+		"  -q, --quality Q       best, high, medium, fast or 0-3 (default: best)\n"
+		"  -t, --threads N       CAS threads (default: logical processors)\n"
+		"  -d, --depth N         frames queued between threads (default: 4)\n"
+		"  -N, --numa-node N     run CAS and place frames on NUMA node N\n"
+		"      --trace FILE      record per-frame spans as Chrome trace-event JSON\n"
+		"      --quiet           do not print throughput\n"
+		"  -h, --help\n");
+}
+
+static bool ParseQuality(const char *text, int *quality)
+{
+	static const char *const kNames[kCasQualityLevels] = {"best", "high", "medium", "fast"};
+
+	for (int i=0; i<kCasQualityLevels; ++i)
+	{
+		if (0 == strcmp(kNames[i], text))
+		{
+			*quality = i;
+			return true;
+		}
+	}
+
+	char *end;
+	long value = strtol(text, &end, 10);
+	if (end == text || *end || value < 0 || kCasQualityLevels <= value)
+		return false;
+
+	*quality = static_cast<int>(value);
+	return true;
+}
+
+static bool ParseOptions(int argc, char **argv, Options *options)
+{
+	int positional = 0;
+
+	options->format = kFormatY4m;
+	options->width = 0;
+	options->height = 0;
+	options->sharpness = 0.8f;
+	options->quality = kCasQualityBest;
+	options->threads = 0;
+	options->depth = 4;
+	options->numa_node = -1;
+	options->trace_path = nullptr;
+	options->quiet = false;
+	options->input_path = "-";
+	options->output_path = "-";
+
+	for (int i=1; i<argc; ++i)
+	{
+		std::string arg = argv[i];
+		const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+		if ("-h" == arg || "--help" == arg)
+		{
+			PrintUsage();
+			exit(EXIT_SUCCESS);
+		}
+		else if ("--quiet" == arg)
+		{
+			options->quiet = true;
+		}
+		else if (("-f" == arg || "--format" == arg) && value)
+		{
+			std::string format = value;
+			if ("y4m" == format)
+				options->format = kFormatY4m;
+			else if ("bgra" == format)
+				options->format = kFormatBgra;
+			else if ("i420" == format)
+				options->format = kFormatI420;
+			else
+				return false;
+			++i;
+		}
+		else if (("-s" == arg || "--size" == arg) && value)
+		{
+			if (2 != sscanf(value, "%dx%d", &options->width, &options->height) || options->width <= 0 || options->height <= 0)
+				return false;
+			++i;
+		}
+		else if (("-S" == arg || "--sharpness" == arg) && value)
+		{
+			options->sharpness = std::clamp(static_cast<float>(atof(value)), 0.0f, 1.0f);
+			++i;
+		}
+		else if (("-q" == arg || "--quality" == arg) && value)
+		{
+			if (!ParseQuality(value, &options->quality))
+				return false;
+			++i;
+		}
+		else if (("-t" == arg || "--threads" == arg) && value)
+		{
+			options->threads = std::max(0, atoi(value));
+			++i;
+		}
+		else if (("-d" == arg || "--depth" == arg) && value)
+		{
+			options->depth = std::max(1, atoi(value));
+			++i;
+		}
+		else if ("--trace" == arg && value)
+		{
+			options->trace_path = value;
+			++i;
+		}
+		else if (("-N" == arg || "--numa-node" == arg) && value)
+		{
+			options->numa_node = atoi(value);
+			if (options->numa_node < 0 || CasNumaNodeCount() <= options->numa_node)
+				return false;
+			++i;
+		}
+		else if ('-' == arg[0] && 1 < arg.size())
+		{
+			return false;
+		}
+		else if (0 == positional)
+		{
+			options->input_path = argv[i];
+			++positional;
+		}
+		else if (1 == positional)
+		{
+			options->output_path = argv[i];
+			++positional;
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	if (kFormatY4m != options->format && (options->width <= 0 || options->height <= 0))
+		return false;
+
+	return true;
+}
+
+static FILE *OpenFile(const char *path, bool write)
+{
+	if (0 == strcmp("-", path))
+	{
+		FILE *file = write ? stdout : stdin;
+#ifdef _WIN32
+		_setmode(_fileno(file), _O_BINARY);
+#endif
+		return file;
+	}
+
+	return fopen(path, write ? "wb" : "rb");
+}
+
+// ʏ̃t@Cł΁AŜǍpmmap
+static void MapInput(Input *input)
+{
+	input->map = nullptr;
+	input->map_size = 0;
+	input->map_pos = 0;
+
+#ifndef _WIN32
+	struct stat st;
+	int fd = fileno(input->file);
+
+	if (0 != fstat(fd, &st) || !S_ISREG(st.st_mode) || st.st_size <= 0)
+		return;
+
+	void *map = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	if (MAP_FAILED == map)
+		return;
+
+	posix_madvise(map, static_cast<size_t>(st.st_size), POSIX_MADV_SEQUENTIAL);
+
+	input->map = static_cast<const uint8_t *>(map);
+	input->map_size = static_cast<size_t>(st.st_size);
+#endif
+}
+
+static void UnmapInput(Input *input)
+{
+#ifndef _WIN32
+	if (input->map)
+		munmap(const_cast<uint8_t *>(input->map), input->map_size);
+#endif
+}
+
+// It[̃y[W̃vZXO
+// glibc  posix_madvise(POSIX_MADV_DONTNEED) ͉Ȃ madvise p
+// ǂݍ݂݂̂ MAP_PRIVATE Ȃ̂ MADV_DONTNEED œe͎ꂸA풓y[W͏̃t[̕ɗ܂
+// MADV_PAGEOUT ꍇ͐Ƀy[WLbVǂo悤߂ (ÂJ[lł͎s邪)
+static void ReleaseView(const Input *input, const uint8_t *view, size_t size)
+{
+#ifndef _WIN32
+	static const uintptr_t kPageMask = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE)) - 1;
+
+	if (!input->map)
+		return;
+
+	uintptr_t begin = (reinterpret_cast<uintptr_t>(view) + kPageMask) & ~kPageMask;
+	uintptr_t end = (reinterpret_cast<uintptr_t>(view) + size) & ~kPageMask;
+	if (begin >= end)
+		return;
+
+	void *page = reinterpret_cast<void *>(begin);
+#ifdef MADV_PAGEOUT
+	madvise(page, end - begin, MADV_PAGEOUT);
+#endif
+	madvise(page, end - begin, MADV_DONTNEED);
+#endif
+}
+
+static bool ReadLine(Input *input, std::string *line)
+{
+	line->clear();
+
+	if (input->map)
+	{
+		const uint8_t *begin = input->map + input->map_pos;
+		const uint8_t *end = static_cast<const uint8_t *>(memchr(begin, '\n', input->map_size - input->map_pos));
+		if (!end)
+			return false;
+
+		line->assign(reinterpret_cast<const char *>(begin), end - begin);
+		input->map_pos += end - begin + 1;
+		return true;
+	}
+
+	for (;;)
+	{
+		int c = fgetc(input->file);
+		if (EOF == c)
+			return false;
+		if ('\n' == c)
+			return true;
+		line->push_back(static_cast<char>(c));
+	}
+}
+
+// Y4M̃Xg[wb_ǂ݁A傫ƐF̌`𓾂
+static bool ParseY4mHeader(const std::string &header, int *width, int *height, Y4mChroma *chroma)
+{
+	if (0 != header.compare(0, 9, "YUV4MPEG2"))
+		return false;
+
+	*width = 0;
+	*height = 0;
+	*chroma = kY4mChroma420;
+
+	size_t pos = 9;
+	while (pos < header.size())
+	{
+		size_t end = header.find(' ', pos + 1);
+		if (std::string::npos == end)
+			end = header.size();
+
+		std::string token = header.substr(pos + 1, end - pos - 1);
+		if (!token.empty())
+		{
+			switch (token[0])
+			{
+			case 'W':
+				*width = atoi(token.c_str() + 1);
+				break;
+
+			case 'H':
+				*height = atoi(token.c_str() + 1);
+				break;
+
+			case 'C':
+				if ("Cmono" == token)
+					*chroma = kY4mChromaMono;
+				else if ("C420jpeg" == token || "C420paldv" == token || "C420mpeg2" == token || "C420" == token)
+					*chroma = kY4mChroma420;
+				else
+					return false;
+				break;
+			}
+		}
+
+		pos = end;
+	}
+
+	return 0 < *width && 0 < *height;
+}
+
+static FrameLayout MakeLayout(bool bgra, bool mono, int width, int height)
+{
+	FrameLayout layout;
+
+	layout.bgra = bgra;
+	layout.width = width;
+	layout.height = height;
+	if (bgra)
+	{
+		layout.luma_size = static_cast<size_t>(width) * height * 4;
+		layout.frame_size = layout.luma_size;
+	}
+	else
+	{
+		size_t chroma_size = mono ? 0 : static_cast<size_t>((width + 1) / 2) * ((height + 1) / 2);
+		layout.luma_size = static_cast<size_t>(width) * height;
+		layout.frame_size = layout.luma_size + 2 * chroma_size;
+	}
+
+	return layout;
+}
+
+static bool ReadFrame(Pipeline *pipeline, Frame *frame)
+{
+	// Y4Mł́Aet[̑OɃt[wb_
+	if (kFormatY4m == pipeline->format)
+	{
+		std::string line;
+		if (!ReadLine(pipeline->input, &line))
+			return false;
+
+		if (0 != line.compare(0, 5, "FRAME"))
+		{
+			fprintf(stderr, "cas: invalid Y4M frame header\n");
+			pipeline->failed = true;
+			return false;
+		}
+	}
+
+	Input *input = pipeline->input;
+	size_t frame_size = pipeline->layout.frame_size;
+	size_t size;
+
+	if (input->map)
+	{
+		// mmap̈̂܂ܓnAǂ݂𑣂
+		size = std::min(frame_size, input->map_size - input->map_pos);
+		frame->view = input->map + input->map_pos;
+		input->map_pos += size;
+#ifndef _WIN32
+		if (size == frame_size)
+			posix_madvise(const_cast<uint8_t *>(frame->view), size, POSIX_MADV_WILLNEED);
+#endif
+	}
+	else
+	{
+		size = fread(frame->input, 1, frame_size, input->file);
+		frame->view = frame->input;
+	}
+
+	if (size != frame_size)
+	{
+		if (0 != size)
+		{
+			fprintf(stderr, "cas: truncated frame\n");
+			pipeline->failed = true;
+		}
+		return false;
+	}
+
+	return true;
+}
+
+static bool WriteFrame(Pipeline *pipeline, const Frame *frame)
+{
+	const FrameLayout &layout = pipeline->layout;
+	FILE *file = pipeline->output->file;
+
+	if (kFormatY4m == pipeline->format && 6 != fwrite("FRAME\n", 1, 6, file))
+		return false;
+
+	// F̕ʂCASKpȂ̂ŁA͂̂܂܏
+	if (layout.luma_size != fwrite(frame->output, 1, layout.luma_size, file))
+		return false;
+
+	size_t rest = layout.frame_size - layout.luma_size;
+	if (rest && rest != fwrite(frame->view + layout.luma_size, 1, rest, file))
+		return false;
+
+	return true;
+}
+
+#if CAS_HAVE_IO_URING
+// ʏ̃t@Cł΁Aio_uring ŏ
+// pCvȂǂł͏̏ۏ؂Ȃ߁Astdioŏ
+static void SetupUring(Output *output, unsigned entries)
+{
+	struct stat st;
+	int fd = fileno(output->file);
+
+	output->uring = nullptr;
+	output->offset = 0;
+
+	if (0 != fstat(fd, &st) || !S_ISREG(st.st_mode))
+		return;
+
+	off_t offset = ftello(output->file);
+	if (offset < 0)
+		return;
+
+	output->uring = UringWriterCreate(fd, entries);
+	output->offset = static_cast<uint64_t>(offset);
+}
+
+static bool SubmitFrame(Pipeline *pipeline, Frame *frame)
+{
+	static const char kFrameHeader[] = "FRAME\n";
+	const FrameLayout &layout = pipeline->layout;
+	Output *output = pipeline->output;
+	struct iovec iov[3];
+	int iov_count = 0;
+
+	if (kFormatY4m == pipeline->format)
+	{
+		iov[iov_count].iov_base = const_cast<char *>(kFrameHeader);
+		iov[iov_count].iov_len = sizeof (kFrameHeader) - 1;
+		++iov_count;
+	}
+
+	iov[iov_count].iov_base = frame->output;
+	iov[iov_count].iov_len = layout.luma_size;
+	++iov_count;
+
+	if (layout.luma_size < layout.frame_size)
+	{
+		iov[iov_count].iov_base = const_cast<uint8_t *>(frame->view + layout.luma_size);
+		iov[iov_count].iov_len = layout.frame_size - layout.luma_size;
+		++iov_count;
+	}
+
+	size_t size = 0;
+	for (int i=0; i<iov_count; ++i)
+		size += iov[i].iov_len;
+
+	if (!UringWriterSubmit(output->uring, iov, iov_count, output->offset, frame))
+		return false;
+
+	output->offset += size;
+
+	return true;
+}
+
+// 1҂Ãt[
+static void CompleteFrame(Pipeline *pipeline)
+{
+	void *user_data = nullptr;
+
+	if (UringWriterWait(pipeline->output->uring, &user_data))
+		++pipeline->frame_count;
+	else if (!pipeline->failed.exchange(true))
+		fprintf(stderr, "cas: write error\n");
+
+	if (!user_data)
+		return;
+
+	Frame *frame = static_cast<Frame *>(user_data);
+	ReleaseView(pipeline->input, frame->view, pipeline->layout.frame_size);
+	pipeline->free_frames->Push(frame);
+}
+
+static void UringWriterMain(Pipeline *pipeline)
+{
+	UringWriter *uring = pipeline->output->uring;
+	unsigned depth = static_cast<unsigned>(pipeline->options->depth);
+	bool tracing = CasTraceEnabled();
+
+	for (int64_t index=0; ; ++index)
+	{
+		Frame *frame = pipeline->write_frames->Pop();
+		if (!frame)
+			break;
+
+		if (pipeline->failed)
+		{
+			pipeline->free_frames->Push(frame);
+			continue;
+		}
+
+		// io_uring ł͏̊҂Ȃ߁A҂ƓɂԂL^
+		uint64_t start = tracing ? CasTraceNow() : 0;
+		if (depth <= UringWriterInFlight(uring))
+			CompleteFrame(pipeline);
+
+		if (!SubmitFrame(pipeline, frame))
+		{
+			if (!pipeline->failed.exchange(true))
+				fprintf(stderr, "cas: write error\n");
+			pipeline->free_frames->Push(frame);
+		}
+		else if (tracing)
+		{
+			CasTraceSpan("write", "frame", start, CasTraceNow(), index);
+		}
+	}
+
+	while (UringWriterInFlight(uring))
+		CompleteFrame(pipeline);
+}
+#endif
+
+static void ReaderMain(Pipeline *pipeline)
+{
+	bool tracing = CasTraceEnabled();
+
+	for (int64_t index=0; ; ++index)
+	{
+		Frame *frame = pipeline->free_frames->Pop();
+
+		uint64_t start = tracing ? CasTraceNow() : 0;
+		if (pipeline->failed || !ReadFrame(pipeline, frame))
+			break;
+		if (tracing)
+			CasTraceSpan("read", "frame", start, CasTraceNow(), index);
+
+		pipeline->work_frames->Push(frame);
+	}
+
+	pipeline->work_frames->Push(nullptr);
+}
+
+static void CasWorkerMain(Pipeline *pipeline)
+{
+	const Options *options = pipeline->options;
+	const FrameLayout &layout = pipeline->layout;
+
+	// ̃XbhCAS̏ɉ邽߁AGW̃[J[Ɠm[hɌŒ肷
+	if (0 <= options->numa_node)
+		CasNumaPinThread(options->numa_node);
+
+	bool tracing = CasTraceEnabled();
+
+	for (int64_t index=0; ; ++index)
+	{
+		Frame *frame = pipeline->work_frames->Pop();
+		if (!frame)
+			break;
+
+		uint64_t start = tracing ? CasTraceNow() : 0;
+		CasCpuImage src;
+		src.pixels = const_cast<uint8_t *>(frame->view);
+		src.pitch = layout.bgra ? layout.width * 4 : layout.width;
+		src.width = layout.width;
+		src.height = layout.height;
+
+		CasCpuImage dst = src;
+		dst.pixels = frame->output;
+
+		bool filtered;
+		if (layout.bgra)
+			filtered = CasCpuFilter(pipeline->engine, &src, &dst, options->sharpness, options->quality);
+		else
+			filtered = CasCpuFilterPlane(pipeline->engine, &src, &dst, options->sharpness, options->quality);
+
+		// o͎š̃t[ɉ
+		if (!filtered && !pipeline->failed.exchange(true))
+			fprintf(stderr, "cas: out of memory\n");
+
+		if (tracing)
+			CasTraceSpan("cas", "frame", start, CasTraceNow(), index);
+
+		pipeline->write_frames->Push(frame);
+	}
+
+	pipeline->write_frames->Push(nullptr);
+}
+
+static void WriterMain(Pipeline *pipeline)
+{
+#if CAS_HAVE_IO_URING
+	if (pipeline->output->uring)
+	{
+		UringWriterMain(pipeline);
+		return;
+	}
+#endif
+
+	bool tracing = CasTraceEnabled();
+
+	for (int64_t index=0; ; ++index)
+	{
+		Frame *frame = pipeline->write_frames->Pop();
+		if (!frame)
+			break;
+
+		// oɎsꍇAǍ~܂܂Ńt[
+		if (!pipeline->failed)
+		{
+			uint64_t start = tracing ? CasTraceNow() : 0;
+			if (WriteFrame(pipeline, frame))
+			{
+				++pipeline->frame_count;
+				if (tracing)
+					CasTraceSpan("write", "frame", start, CasTraceNow(), index);
+			}
+			else
+			{
+				fprintf(stderr, "cas: write error\n");
+				pipeline->failed = true;
+			}
+		}
+
+		ReleaseView(pipeline->input, frame->view, pipeline->layout.frame_size);
+		pipeline->free_frames->Push(frame);
+	}
+
+	fflush(pipeline->output->file);
+}
+
+int main(int argc, char **argv)
+{
+	Options options;
+
+	if (!ParseOptions(argc, argv, &options))
+	{
+		PrintUsage();
+		return EXIT_FAILURE;
+	}
+
+	Input input;
+	input.file = OpenFile(options.input_path, false);
+	if (!input.file)
+	{
+		fprintf(stderr, "cas: can not open %s\n", options.input_path);
+		return EXIT_FAILURE;
+	}
+
+	Output output;
+	output.file = OpenFile(options.output_path, true);
+	if (!output.file)
+	{
+		fprintf(stderr, "cas: can not open %s\n", options.output_path);
+		return EXIT_FAILURE;
+	}
+
+	MapInput(&input);
+
+	FrameLayout layout;
+	if (kFormatY4m == options.format)
+	{
+		std::string header;
+		int width;
+		int height;
+		Y4mChroma chroma;
+
+		if (!ReadLine(&input, &header) || !ParseY4mHeader(header, &width, &height, &chroma))
+		{
+			fprintf(stderr, "cas: unsupported Y4M stream (only 8-bit 4:2:0 and mono)\n");
+			return EXIT_FAILURE;
+		}
+
+		// Xg[wb_͂̂܂܏
+		header.push_back('\n');
+		if (header.size() != fwrite(header.data(), 1, header.size(), output.file) || 0 != fflush(output.file))
+		{
+			fprintf(stderr, "cas: write error\n");
+			return EXIT_FAILURE;
+		}
+
+		layout = MakeLayout(false, kY4mChromaMono == chroma, width, height);
+	}
+	else
+	{
+		layout = MakeLayout(kFormatBgra == options.format, false, options.width, options.height);
+	}
+
+	CasCpuEngine *engine = CasCpuCreateOnNode(options.threads, options.numa_node);
+	if (!engine)
+	{
+		fprintf(stderr, "cas: can not create CAS engine\n");
+		return EXIT_FAILURE;
+	}
+
+	// eL[tɂȂAeXbh1t[ĂĂ鐔̃t[pӂ
+	size_t frame_count = 3 * options.depth + 3;
+	std::vector<Frame> frames(frame_count);
+	SpscQueue<Frame *> free_frames(frame_count);
+	SpscQueue<Frame *> work_frames(options.depth + 1);
+	SpscQueue<Frame *> write_frames(options.depth + 1);
+
+	// 8K̃t[1100MiB𒴂邽߁Aq[Wy[WŊmۂACASŏcɒHۂTLB̎Ⴆ炷
+	size_t input_size = input.map ? 0 : CasArenaPitch(layout.frame_size);
+	size_t output_size = CasArenaPitch(layout.luma_size);
+	CasArena arena;
+	if (!CasArenaCreateOnNode(&arena, (input_size + output_size) * frame_count, true, options.numa_node))
+	{
+		fprintf(stderr, "cas: can not allocate frames\n");
+		CasCpuDestroy(engine);
+		return EXIT_FAILURE;
+	}
+
+	for (Frame &frame : frames)
+	{
+		frame.input = input_size ? static_cast<uint8_t *>(CasArenaAlloc(&arena, input_size)) : nullptr;
+		frame.output = static_cast<uint8_t *>(CasArenaAlloc(&arena, output_size));
+		frame.view = nullptr;
+		free_frames.Push(&frame);
+	}
+
+#if CAS_HAVE_IO_URING
+	SetupUring(&output, static_cast<unsigned>(options.depth));
+#endif
+
+	Pipeline pipeline;
+	pipeline.options = &options;
+	pipeline.layout = layout;
+	pipeline.format = options.format;
+	pipeline.input = &input;
+	pipeline.output = &output;
+	pipeline.engine = engine;
+	pipeline.free_frames = &free_frames;
+	pipeline.work_frames = &work_frames;
+	pipeline.write_frames = &write_frames;
+	pipeline.failed = false;
+	pipeline.frame_count = 0;
+
+	if (options.trace_path && !CasTraceOpen(options.trace_path))
+		fprintf(stderr, "cas: can not open %s, tracing is disabled\n", options.trace_path);
+	CasCpuSetTracing(engine, CasTraceEnabled());
+
+	auto start = std::chrono::steady_clock::now();
+
+	std::thread reader(ReaderMain, &pipeline);
+	std::thread worker(CasWorkerMain, &pipeline);
+	std::thread writer(WriterMain, &pipeline);
+	reader.join();
+	worker.join();
+	writer.join();
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	CasCpuDestroy(engine);
+	if (options.trace_path)
+		CasTraceClose();
+#if CAS_HAVE_IO_URING
+	UringWriterDestroy(output.uring);
+#endif
+	CasArenaDestroy(&arena);
+	UnmapInput(&input);
+	if (stdin != input.file)
+		fclose(input.file);
+	if (stdout != output.file && 0 != fclose(output.file))
+		pipeline.failed = true;
+
+	if (!options.quiet)
+	{
+		double megabytes = static_cast<double>(pipeline.frame_count) * layout.frame_size / (1024.0 * 1024.0);
+		fprintf(stderr, "cas: %llu frames %dx%d in %.3f s, %.2f fps, %.1f MiB/s\n",
+			static_cast<unsigned long long>(pipeline.frame_count), layout.width, layout.height, seconds,
+			0.0 < seconds ? pipeline.frame_count / seconds : 0.0,
+			0.0 < seconds ? megabytes / seconds : 0.0);
+	}
+
+	return pipeline.failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,325 @@
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include <algorithm>
+#include <new>
+#include <vector>
+
+#include "cas_uring.h"
+
+
+// 1̏ɓn iovec ̍ő吔
+static const int kMaxIov = 4;
+
+struct UringRequest
+{
+	struct iovec iov[kMaxIov];
+	int iov_count;
+	uint64_t offset;
+	size_t size;
+	void *user_data;
+	bool used;
+};
+
+struct UringWriter
+{
+	int ring_fd_;
+	int fd_;
+	unsigned entries_;
+	unsigned in_flight_;
+	// s io_uring_enter  errno
+	// ɎsSQE̓OɎcA̓őĂ܂߁Aȍ~͓Ȃ
+	int error_;
+	bool dead_; // ҂ĂȂȂAcׂ̏͂ĎsƂĕԂ
+
+	void *sq_ring_;
+	size_t sq_ring_size_;
+	void *cq_ring_;
+	size_t cq_ring_size_;
+	struct io_uring_sqe *sqes_;
+	size_t sqes_size_;
+
+	unsigned *sq_tail_;
+	unsigned sq_mask_;
+	unsigned *sq_array_;
+	unsigned *cq_head_;
+	unsigned *cq_tail_;
+	unsigned cq_mask_;
+	struct io_uring_cqe *cqes_;
+
+	std::vector<UringRequest> requests_;
+};
+
+
+static int IoUringSetup(unsigned entries, struct io_uring_params *params)
+{
+	return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int IoUringEnter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+	return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+// ŐLϐ́AJ[lƂ̊Ԃ acquire/release ̏ۂ
+static unsigned LoadAcquire(const unsigned *p)
+{
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static void StoreRelease(unsigned *p, unsigned value)
+{
+	__atomic_store_n(p, value, __ATOMIC_RELEASE);
+}
+
+// c𓯊Iɏ
+static bool WriteRest(int fd, const UringRequest &request, size_t written)
+{
+	uint64_t offset = request.offset;
+
+	for (int i=0; i<request.iov_count; ++i)
+	{
+		const uint8_t *base = static_cast<const uint8_t *>(request.iov[i].iov_base);
+		size_t length = request.iov[i].iov_len;
+
+		if (length <= written)
+		{
+			written -= length;
+			offset += length;
+			continue;
+		}
+
+		base += written;
+		offset += written;
+		length -= written;
+		written = 0;
+
+		while (length)
+		{
+			ssize_t result = pwrite(fd, base, length, static_cast<off_t>(offset));
+			if (result < 0 && EINTR == errno)
+				continue;
+			if (result <= 0)
+				return false;
+
+			base += result;
+			offset += result;
+			length -= result;
+		}
+	}
+
+	return true;
+}
+
+UringWriter *UringWriterCreate(int fd, unsigned entries)
+{
+	struct io_uring_params params;
+	memset(&params, 0, sizeof (params));
+
+	int ring_fd = IoUringSetup(entries, &params);
+	if (ring_fd < 0)
+		return nullptr;
+
+	UringWriter *writer = new(std::nothrow) UringWriter();
+	if (!writer)
+	{
+		close(ring_fd);
+		return nullptr;
+	}
+
+	writer->ring_fd_ = ring_fd;
+	writer->fd_ = fd;
+	writer->entries_ = std::min(entries, params.sq_entries);
+	writer->in_flight_ = 0;
+	writer->error_ = 0;
+	writer->dead_ = false;
+
+	writer->sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof (unsigned);
+	writer->cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof (struct io_uring_cqe);
+	if (IORING_FEAT_SINGLE_MMAP & params.features)
+	{
+		writer->sq_ring_size_ = std::max(writer->sq_ring_size_, writer->cq_ring_size_);
+		writer->cq_ring_size_ = writer->sq_ring_size_;
+	}
+
+	writer->sq_ring_ = mmap(nullptr, writer->sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+	if (MAP_FAILED == writer->sq_ring_)
+	{
+		writer->sq_ring_ = nullptr;
+		UringWriterDestroy(writer);
+		return nullptr;
+	}
+
+	if (IORING_FEAT_SINGLE_MMAP & params.features)
+	{
+		writer->cq_ring_ = writer->sq_ring_;
+	}
+	else
+	{
+		writer->cq_ring_ = mmap(nullptr, writer->cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+		if (MAP_FAILED == writer->cq_ring_)
+		{
+			writer->cq_ring_ = nullptr;
+			UringWriterDestroy(writer);
+			return nullptr;
+		}
+	}
+
+	writer->sqes_size_ = params.sq_entries * sizeof (struct io_uring_sqe);
+	void *sqes = mmap(nullptr, writer->sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+	if (MAP_FAILED == sqes)
+	{
+		UringWriterDestroy(writer);
+		return nullptr;
+	}
+	writer->sqes_ = static_cast<struct io_uring_sqe *>(sqes);
+
+	uint8_t *sq = static_cast<uint8_t *>(writer->sq_ring_);
+	uint8_t *cq = static_cast<uint8_t *>(writer->cq_ring_);
+	writer->sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+	writer->sq_mask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+	writer->sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+	writer->cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+	writer->cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+	writer->cq_mask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+	writer->cqes_ = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+
+	writer->requests_.resize(writer->entries_);
+
+	return writer;
+}
+
+void UringWriterDestroy(UringWriter *writer)
+{
+	if (!writer)
+		return;
+
+	if (writer->sqes_)
+		munmap(writer->sqes_, writer->sqes_size_);
+	if (writer->cq_ring_ && writer->cq_ring_ != writer->sq_ring_)
+		munmap(writer->cq_ring_, writer->cq_ring_size_);
+	if (writer->sq_ring_)
+		munmap(writer->sq_ring_, writer->sq_ring_size_);
+	close(writer->ring_fd_);
+
+	delete writer;
+}
+
+bool UringWriterSubmit(UringWriter *writer, const struct iovec *iov, int iov_count, uint64_t offset, void *user_data)
+{
+	if (writer->error_)
+	{
+		errno = writer->error_;
+		return false;
+	}
+
+	if (writer->entries_ <= writer->in_flight_ || iov_count <= 0 || kMaxIov < iov_count)
+		return false;
+
+	unsigned slot = 0;
+	while (writer->requests_[slot].used)
+		++slot;
+
+	UringRequest &request = writer->requests_[slot];
+	memcpy(request.iov, iov, iov_count * sizeof (struct iovec));
+	request.iov_count = iov_count;
+	request.offset = offset;
+	request.size = 0;
+	for (int i=0; i<iov_count; ++i)
+		request.size += iov[i].iov_len;
+	request.user_data = user_data;
+	request.used = true;
+
+	// SQE1߂ĂAtaili߂
+	unsigned tail = *writer->sq_tail_;
+	unsigned index = tail & writer->sq_mask_;
+	struct io_uring_sqe *sqe = &writer->sqes_[index];
+	memset(sqe, 0, sizeof (*sqe));
+	sqe->opcode = IORING_OP_WRITEV;
+	sqe->fd = writer->fd_;
+	sqe->off = offset;
+	sqe->addr = reinterpret_cast<uint64_t>(request.iov);
+	sqe->len = static_cast<uint32_t>(iov_count);
+	sqe->user_data = slot;
+	writer->sq_array_[index] = index;
+	StoreRelease(writer->sq_tail_, tail + 1);
+
+	int result;
+	do
+	{
+		result = IoUringEnter(writer->ring_fd_, 1, 0, 0);
+	} while (result < 0 && EINTR == errno);
+
+	if (result < 0)
+	{
+		writer->error_ = errno;
+		request.used = false;
+		return false;
+	}
+
+	++writer->in_flight_;
+
+	return true;
+}
+
+bool UringWriterWait(UringWriter *writer, void **user_data)
+{
+	if (!writer->in_flight_)
+		return false;
+
+	for (;;)
+	{
+		unsigned head = *writer->cq_head_;
+		if (head != LoadAcquire(writer->cq_tail_))
+		{
+			struct io_uring_cqe *cqe = &writer->cqes_[head & writer->cq_mask_];
+			UringRequest &request = writer->requests_[cqe->user_data];
+			int result = cqe->res;
+			StoreRelease(writer->cq_head_, head + 1);
+
+			request.used = false;
+			--writer->in_flight_;
+			*user_data = request.user_data;
+
+			if (result < 0)
+			{
+				errno = -result;
+				return false;
+			}
+
+			if (static_cast<size_t>(result) < request.size)
+				return WriteRest(writer->fd_, request, static_cast<size_t>(result));
+
+			return true;
+		}
+
+		if (writer->dead_)
+		{
+			// m߂Ȃ́A11sƂĕԂAďoɉ
+			UringRequest *request = &*std::find_if(writer->requests_.begin(), writer->requests_.end(), [](const UringRequest &r){return r.used;});
+			request->used = false;
+			--writer->in_flight_;
+			*user_data = request->user_data;
+			errno = writer->error_;
+			return false;
+		}
+
+		// 鐔0̂߁AOɎcɎsSQE͑Ȃ
+		int result = IoUringEnter(writer->ring_fd_, 0, 1, IORING_ENTER_GETEVENTS);
+		if (result < 0 && EINTR != errno)
+		{
+			writer->error_ = errno;
+			writer->dead_ = true;
+		}
+	}
+}
+
+unsigned UringWriterInFlight(const UringWriter *writer)
+{
+	return writer->in_flight_;
+}
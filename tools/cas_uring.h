@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <sys/uio.h>
+
+
+// io_uring ŕ̏𓯎ɍs
+// liburing ɂ͈ˑAVXeR[𒼐ڗp
+struct UringWriter;
+
+
+// entries ͓ɍs̍ő吔
+// io_uring 𗘗płȂꍇ nullptr Ԃ
+UringWriter *UringWriterCreate(int fd, unsigned entries);
+void UringWriterDestroy(UringWriter *writer);
+
+// iov ̓e fd  offset ̈ʒuɏJn
+// iov ẅ́A܂Ōďoێ邱
+// ɍsĂ鏑 entries ̏ꍇ͎s
+// io_uring_enter xsƁAȍ~̌ďoׂ͂Ďs
+bool UringWriterSubmit(UringWriter *writer, const struct iovec *iov, int iov_count, uint64_t offset, void *user_data);
+
+// ̊1҂AJn user_data Ԃ
+// ꕔȂꍇ́Ac𓯊Iɏ
+// ҂ĂȂȂꍇ́Ac̏11sƂĕԂ߁AsĂ InFlight ͌
+bool UringWriterWait(UringWriter *writer, void **user_data);
+
+unsigned UringWriterInFlight(const UringWriter *writer);